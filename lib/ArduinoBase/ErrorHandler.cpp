@@ -18,6 +18,7 @@
 // 26.09.2022: EXTERNAL_EEPROM defined in platform.ini - Stefan Rau
 // 26.09.2022: DEBUG_APPLICATION defined in platform.ini - Stefan Rau
 // 21.12.2022: extend destructor - Stefan Rau
+// 18.10.2026: thread-safe initialization of the singleton - Stefan Rau
 
 #include "ErrorHandler.h"
 
@@ -156,8 +157,6 @@ Error::sErrorEntry Error::GetErrorEntry()
 
 /////////////////////////////////////////////////////////////
 
-static ErrorHandler *gInstance = nullptr;
-
 ErrorHandler::ErrorHandler(sInitializeModule iInitializeModule) : I2CBase(iInitializeModule)
 {
 
@@ -210,11 +209,11 @@ ErrorHandler *ErrorHandler::GetInstance()
 {
 	DEBUG_METHOD_CALL("ErrorHandler::GetInstance");
 
-	// returns a pointer to singleton instance
-	sInitializeModule lInitializeModule = {-1, -1};
+	// returns a pointer to singleton instance - a static local variable is initialized only once, also with several threads
+	static sInitializeModule lInitializeModule = {-1, -1};
+	static ErrorHandler *lInstance = new ErrorHandler(lInitializeModule);
 
-	gInstance = (gInstance == nullptr) ? new ErrorHandler(lInitializeModule) : gInstance;
-	return gInstance;
+	return lInstance;
 }
 
 void ErrorHandler::loop()
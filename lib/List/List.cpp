@@ -10,10 +10,30 @@
 // 02.06.2023: Add additional debug support and fix bug in destruction - Stefan Rau
 // 10.06.2023: Add and delete return false when failing - Stefan Rau
 // 09.07.2023: Parallel iterations are now possible as well - Stefan Rau
-
+// 18.10.2026: Based on the typed intrusive list template List<T> - Stefan Rau
+// 18.10.2026: Count in constant time, access by index through cursor and index table - Stefan Rau
+// 18.10.2026: Find by key through a hash table - Stefan Rau
+// 18.10.2026: Iteration from interrupts or another core while the main loop adds and deletes elements - Stefan Rau
+// 18.10.2026: Handles with generation for access and removal in constant time - Stefan Rau
+// 18.10.2026: Index table, keys, handles and concurrent readers can be switched off at compile time, off on ARDUINO_AVR_UNO - Stefan Rau
+
+#include <stdlib.h>
 #include "List.h"
 #include "Debug.h"
 
+#if LIST_KEYS
+/// <summary>
+/// Calculates the home entry of a key in the hash table - the multiplication spreads consecutive keys
+/// </summary>
+/// <param name="iKey">Key of an object</param>
+/// <param name="iCapacity">Size of the table, a power of 2</param>
+/// <returns>Entry, where the search for the key starts</returns>
+static uint16_t KeySlot(uint32_t iKey, uint16_t iCapacity)
+{
+	return (uint16_t)((iKey * 2654435769UL) >> 16) & (iCapacity - 1);
+}
+#endif
+
 ListCollection::ListCollection()
 {
 	DEBUG_INSTANTIATION("ListCollection");
@@ -24,17 +44,33 @@ ListCollection::~ListCollection()
 	// destroy all list objects and their contained content objects
 	DEBUG_DESTROY("ListCollection");
 
-	ListElement *lNextObject;
-	ListElement *lCurrentObject = mFirst;
-
-	// Delete each single element and the stored instances
-	while (lCurrentObject != nullptr)
+	// Delete each single element and the stored instances - the iterator has moved on before an element is deleted
+	for (ListElement *lCurrentElement : mElements)
+	{
+		delete lCurrentElement->mObject;
+		delete lCurrentElement;
+	}
+#if LIST_CONCURRENT
+	while (mRetired != nullptr)
+	{
+		ListElement *lNextElement = mRetired->mNextRetired;
+		delete mRetired->mObject;
+		delete mRetired;
+		mRetired = lNextElement;
+	}
+#endif
+#if LIST_INDEX
+	delete[] mIndex;
+#endif
+#if LIST_HANDLES
+	delete[] mSlots;
+#endif
+#if LIST_KEYS
+	if (!mKeyTableFixed)
 	{
-		lNextObject = lCurrentObject->mNext;
-		delete lCurrentObject->mObject;
-		delete lCurrentObject;
-		lCurrentObject = lNextObject;
+		delete[] mKeyTable;
 	}
+#endif
 }
 
 bool ListCollection::Add(void *iObject)
@@ -43,6 +79,9 @@ bool ListCollection::Add(void *iObject)
 
 	ListElement *lNewElement;
 
+#if LIST_CONCURRENT
+	Reclaim();
+#endif
 	lNewElement = new ListElement();
 	if (lNewElement == nullptr)
 	{
@@ -51,23 +90,105 @@ bool ListCollection::Add(void *iObject)
 
 	lNewElement->mObject = iObject;
 
-	if (mFirst == nullptr)
+	// insert new element at the end of the list
+	mElements.Add(lNewElement);
+
+#if LIST_KEYS
+	InsertKey(lNewElement);
+#endif
+
+#if LIST_INDEX
+	// An up to date index table gets the new element, if there is space for it
+	if ((mIndexCount == mElements.Count() - 1) && (mIndexCount < mIndexCapacity))
 	{
-		mFirst = lNewElement;
-		mLast = lNewElement;
+		mIndex[mIndexCount++] = lNewElement;
 	}
-	else
+#endif
+
+	DEBUG_PRINT_LN("Entry inserted into ListCollection");
+	return true;
+}
+
+#if LIST_HANDLES
+bool ListCollection::Add(void *iObject, ListHandle *iHandle)
+{
+	DEBUG_METHOD_CALL("ListCollection::Add");
+
+	uint16_t lSlot;
+
+	// Take a free slot or a new one - the slot table doubles, when it is full
+	if (mFreeSlot == 0)
 	{
-		// insert new element at the end of the list
-		mLast->mNext = lNewElement;
-		lNewElement->mPrevious = mLast;
-		mLast = lNewElement;
+		if (mSlotCount == mSlotCapacity)
+		{
+			uint16_t lCapacity = (mSlotCapacity == 0) ? 4 : ((mSlotCapacity < 0x8000) ? mSlotCapacity * 2 : 0xFFFF);
+			sSlot *lSlots;
+
+			if (lCapacity == mSlotCapacity)
+			{
+				return false;
+			}
+			lSlots = new sSlot[lCapacity];
+			if (lSlots == nullptr)
+			{
+				return false;
+			}
+			for (lSlot = 0; lSlot < mSlotCount; lSlot++)
+			{
+				lSlots[lSlot] = mSlots[lSlot];
+			}
+			delete[] mSlots;
+			mSlots = lSlots;
+			mSlotCapacity = lCapacity;
+		}
+		mSlots[mSlotCount].Generation = 0;
+		mSlots[mSlotCount].NextFree = 0;
+		mFreeSlot = ++mSlotCount;
 	}
+	lSlot = mFreeSlot - 1;
 
-	DEBUG_PRINT_LN("Entry inserted into ListCollection");
+	if (!Add(iObject))
+	{
+		return false;
+	}
+
+	mFreeSlot = mSlots[lSlot].NextFree;
+	mSlots[lSlot].Element = mElements.GetLast();
+	mSlots[lSlot].Element->mSlot = lSlot + 1;
+	iHandle->Slot = lSlot + 1;
+	iHandle->Generation = mSlots[lSlot].Generation;
 	return true;
 }
 
+bool ListCollection::Delete(ListHandle iHandle)
+{
+	DEBUG_METHOD_CALL("ListCollection::Delete");
+
+	return Delete(GetInternal(iHandle));
+}
+
+void *ListCollection::Get(ListHandle iHandle)
+{
+	DEBUG_METHOD_CALL("ListCollection::Get");
+
+	ListElement *lElement = GetInternal(iHandle);
+	return (lElement == nullptr) ? nullptr : lElement->mObject;
+}
+
+ListElement *ListCollection::GetInternal(ListHandle iHandle)
+{
+	DEBUG_METHOD_CALL("ListCollection::GetInternal");
+
+	if ((iHandle.Slot == 0) || (iHandle.Slot > mSlotCount))
+	{
+		return nullptr;
+	}
+
+	sSlot *lSlot = &mSlots[iHandle.Slot - 1];
+	return (lSlot->Generation == iHandle.Generation) ? lSlot->Element : nullptr;
+}
+#endif
+
 bool ListCollection::Delete(ListElement *iCurrentElement)
 {
 	DEBUG_METHOD_CALL("ListCollection::Delete");
@@ -78,50 +199,62 @@ bool ListCollection::Delete(ListElement *iCurrentElement)
 		return false;
 	}
 
-	// Process one and only element
-	if ((iCurrentElement->mPrevious == nullptr) && (iCurrentElement->mNext == nullptr))
+	if (!mElements.Contains(iCurrentElement))
 	{
-		mFirst = nullptr;
-		mLast = nullptr;
+		// If the element is not part of this list
+		return false;
 	}
 
-	// Adapt the element before
-	if (iCurrentElement->mPrevious != nullptr)
+#if LIST_INDEX
+	if (iCurrentElement == mCursor)
+	{
+		// The successor moves to the index of the deleted element, so loops deleting by index stay fast.
+		// Index table entries before the deleted element are still valid.
+		mIndexCount = (mIndexCount < mCursorIndex) ? mIndexCount : mCursorIndex;
+		mCursor = mCursor->mNext;
+	}
+	else
 	{
-		// If a predecessor exists
+		// The index of the element is unknown
+		mCursor = nullptr;
+		mIndexCount = 0;
+	}
+	if (mIndexCount == 0)
+	{
+		mWalkedSteps = 0;
+	}
+#endif
+#if LIST_KEYS
+	RemoveKey(iCurrentElement);
+#endif
+	mElements.Remove(iCurrentElement);
+
+#if LIST_HANDLES
+	// The slot is reused with a new generation, so the handles of this element become invalid
+	if (iCurrentElement->mSlot != 0)
+	{
+		sSlot *lSlot = &mSlots[iCurrentElement->mSlot - 1];
 
-		if (iCurrentElement->mNext == nullptr)
-		{
-			// the current element is the last one => make entry before the last one
-			iCurrentElement->mPrevious->mNext = nullptr;
-			// Take the previous element as last one
-			mLast = iCurrentElement->mPrevious;
-		}
-		else
-		{
-			// If a successor exists => entry before points to the successor of the current entry
-			iCurrentElement->mPrevious->mNext = iCurrentElement->mNext;
-		}
+		lSlot->Element = nullptr;
+		lSlot->Generation++;
+		lSlot->NextFree = mFreeSlot;
+		mFreeSlot = iCurrentElement->mSlot;
+		iCurrentElement->mSlot = 0;
 	}
+#endif
 
-	// Adapt the element after
-	if (iCurrentElement->mNext != nullptr)
+#if LIST_CONCURRENT
+	if (!NoReaders())
 	{
-		// If a successor exists
-
-		if (iCurrentElement->mPrevious == nullptr)
-		{
-			// the current element is the 1st one => make entry after the 1st one
-			iCurrentElement->mNext->mPrevious = nullptr;
-			// Take the next element as 1st one
-			mFirst = iCurrentElement->mNext;
-		}
-		else
-		{
-			// If a predecessor exists => entry after points to the predecessor of the current entry
-			iCurrentElement->mNext->mPrevious = iCurrentElement->mPrevious;
-		}
+		// A reader could stand on the element, it is freed after all current readers have ended
+		// The own link keeps mPrevious cleared, so the element is no longer part of the list for a 2nd Delete
+		iCurrentElement->mNextRetired = mRetired;
+		mRetired = iCurrentElement;
+		DEBUG_PRINT_LN("Entry deleted from ListCollection");
+		return true;
 	}
+	Reclaim();
+#endif
 
 	// Rempove current element from memory
 	if (iCurrentElement->mObject != nullptr)
@@ -147,13 +280,13 @@ bool ListCollection::Delete(int iIndex)
 void *ListCollection::GetFirst()
 {
 	DEBUG_METHOD_CALL("ListCollection::GetFirst");
-	return mFirst->mObject;
+	return mElements.GetFirst()->mObject;
 }
 
 void *ListCollection::GetLast()
 {
 	DEBUG_METHOD_CALL("ListCollection::GetLast");
-	return mLast->mObject;
+	return mElements.GetLast()->mObject;
 }
 
 void *ListCollection::Get(int iIndex)
@@ -168,21 +301,249 @@ ListElement *ListCollection::GetInternal(int iIndex)
 {
 	DEBUG_METHOD_CALL("ListCollection::GetInternal");
 
-	int lIterator = 0;
+	ListElement *lElement;
+	int lIndex;
+	int lLast = (int)mElements.Count() - 1;
+	uint16_t lSteps = 0;
+
+	if ((iIndex < 0) || (iIndex > lLast))
+	{
+		// Element not found, index is out of range
+		return nullptr;
+	}
+#if LIST_INDEX
+	if (iIndex < mIndexCount)
+	{
+		return mIndex[iIndex];
+	}
+#endif
+
+	// Walk from the nearest known position: start, end, last valid index table entry or cursor
+	if (iIndex <= lLast - iIndex)
+	{
+		lElement = mElements.GetFirst();
+		lIndex = 0;
+	}
+	else
+	{
+		lElement = mElements.GetLast();
+		lIndex = lLast;
+	}
+#if LIST_INDEX
+	if ((mIndexCount > 0) && (iIndex - (mIndexCount - 1) < abs(iIndex - lIndex)))
+	{
+		lElement = mIndex[mIndexCount - 1];
+		lIndex = mIndexCount - 1;
+	}
+	if ((mCursor != nullptr) && (abs(iIndex - mCursorIndex) < abs(iIndex - lIndex)))
+	{
+		lElement = mCursor;
+		lIndex = mCursorIndex;
+	}
+#endif
+	for (; lIndex < iIndex; lIndex++, lSteps++)
+	{
+		lElement = lElement->mNext;
+	}
+	for (; lIndex > iIndex; lIndex--, lSteps++)
+	{
+		lElement = lElement->mPrevious;
+	}
+
+#if LIST_INDEX
+	mCursor = lElement;
+	mCursorIndex = iIndex;
+	UpdateIndex(lSteps);
+#endif
+	return lElement;
+}
 
-	for (ListElement *lCurrentElement = mFirst; lCurrentElement != nullptr; lCurrentElement = lCurrentElement->mNext, lIterator++)
+#if LIST_KEYS
+bool ListCollection::SetKey(uint32_t (*iKey)(void *), ListElement **iTable, uint16_t iCapacity)
+{
+	DEBUG_METHOD_CALL("ListCollection::SetKey");
+
+	if ((iCapacity & (iCapacity - 1)) != 0)
 	{
-		if (iIndex == lIterator)
+		return false;
+	}
+
+	if (!mKeyTableFixed)
+	{
+		delete[] mKeyTable;
+	}
+	mKey = iKey;
+	mKeyTable = iTable;
+	mKeyCapacity = (iTable == nullptr) ? 0 : iCapacity;
+	mKeyCount = 0;
+	mKeyTableFixed = (iTable != nullptr);
+	mKeyOverflow = false;
+	for (uint16_t lSlot = 0; lSlot < mKeyCapacity; lSlot++)
+	{
+		mKeyTable[lSlot] = nullptr;
+	}
+
+	for (ListElement *lCurrentElement : mElements)
+	{
+		InsertKey(lCurrentElement);
+	}
+	return true;
+}
+
+void *ListCollection::Find(uint32_t iKey)
+{
+	DEBUG_METHOD_CALL("ListCollection::Find");
+
+	if (mKey == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (mKeyCount > 0)
+	{
+		// Linear probing ends at the 1st empty entry
+		for (uint16_t lSlot = KeySlot(iKey, mKeyCapacity); mKeyTable[lSlot] != nullptr; lSlot = (lSlot + 1) & (mKeyCapacity - 1))
 		{
-			// return element under this index
-			return lCurrentElement;
+			if (mKey(mKeyTable[lSlot]->mObject) == iKey)
+			{
+				return mKeyTable[lSlot]->mObject;
+			}
 		}
 	}
 
-	// Element not found, index is out of range
+	if (mKeyOverflow)
+	{
+		// Elements, that did not fit into the table, are searched one by one
+		for (ListElement *lCurrentElement : mElements)
+		{
+			if (mKey(lCurrentElement->mObject) == iKey)
+			{
+				return lCurrentElement->mObject;
+			}
+		}
+	}
 	return nullptr;
 }
 
+void ListCollection::InsertKey(ListElement *iElement)
+{
+	uint16_t lSlot;
+
+	if (mKey == nullptr)
+	{
+		return;
+	}
+
+	// A table on the heap grows at a load of 3/4, so the probe sequences stay short
+	if (!mKeyTableFixed && ((mKeyCount + 1) * 4 > mKeyCapacity * 3) && (mKeyCapacity < 0x8000))
+	{
+		uint16_t lCapacity = (mKeyCapacity == 0) ? 8 : mKeyCapacity * 2;
+		ListElement **lTable = new ListElement *[lCapacity];
+
+		if (lTable != nullptr)
+		{
+			for (lSlot = 0; lSlot < lCapacity; lSlot++)
+			{
+				lTable[lSlot] = nullptr;
+			}
+			for (uint16_t lOld = 0; lOld < mKeyCapacity; lOld++)
+			{
+				if (mKeyTable[lOld] != nullptr)
+				{
+					for (lSlot = KeySlot(mKey(mKeyTable[lOld]->mObject), lCapacity); lTable[lSlot] != nullptr; lSlot = (lSlot + 1) & (lCapacity - 1))
+						;
+					lTable[lSlot] = mKeyTable[lOld];
+				}
+			}
+			delete[] mKeyTable;
+			mKeyTable = lTable;
+			mKeyCapacity = lCapacity;
+		}
+	}
+
+	// One entry stays empty, so each search ends
+	if (mKeyCount + 1 >= mKeyCapacity)
+	{
+		mKeyOverflow = true;
+		return;
+	}
+
+	for (lSlot = KeySlot(mKey(iElement->mObject), mKeyCapacity); mKeyTable[lSlot] != nullptr; lSlot = (lSlot + 1) & (mKeyCapacity - 1))
+		;
+	mKeyTable[lSlot] = iElement;
+	mKeyCount++;
+}
+
+void ListCollection::RemoveKey(ListElement *iElement)
+{
+	uint16_t lMask = mKeyCapacity - 1;
+	uint16_t lHole;
+
+	if ((mKey == nullptr) || (mKeyCount == 0))
+	{
+		return;
+	}
+
+	for (lHole = KeySlot(mKey(iElement->mObject), mKeyCapacity); mKeyTable[lHole] != iElement; lHole = (lHole + 1) & lMask)
+	{
+		if (mKeyTable[lHole] == nullptr)
+		{
+			// The element did not fit into the table
+			return;
+		}
+	}
+
+	// Following entries move back into the hole, if it is not before their home entry - no markers for deleted entries are needed
+	for (uint16_t lSlot = (lHole + 1) & lMask; mKeyTable[lSlot] != nullptr; lSlot = (lSlot + 1) & lMask)
+	{
+		uint16_t lHome = KeySlot(mKey(mKeyTable[lSlot]->mObject), mKeyCapacity);
+
+		if (((lSlot - lHome) & lMask) >= ((lSlot - lHole) & lMask))
+		{
+			mKeyTable[lHole] = mKeyTable[lSlot];
+			lHole = lSlot;
+		}
+	}
+	mKeyTable[lHole] = nullptr;
+	mKeyCount--;
+}
+#endif
+
+#if LIST_INDEX
+void ListCollection::UpdateIndex(uint16_t iSteps)
+{
+	uint16_t lCount = mElements.Count();
+	uint16_t lIndex = 0;
+
+	// Like renting or buying: the table is built only after walking has cost as much as building it,
+	// so sequential access never builds it and random access takes at most twice the optimal time
+	mWalkedSteps = (mWalkedSteps + iSteps < lCount) ? mWalkedSteps + iSteps : lCount;
+	if (mWalkedSteps < lCount)
+	{
+		return;
+	}
+
+	if (mIndexCapacity < lCount)
+	{
+		ListElement **lIndex = new ListElement *[lCount + lCount / 2];
+
+		if (lIndex == nullptr)
+		{
+			return;
+		}
+		delete[] mIndex;
+		mIndex = lIndex;
+		mIndexCapacity = lCount + lCount / 2;
+	}
+	for (ListElement *lCurrentElement : mElements)
+	{
+		mIndex[lIndex++] = lCurrentElement;
+	}
+	mIndexCount = lCount;
+	mWalkedSteps = 0;
+}
+#endif
+
 void *ListCollection::Filter(bool (*iCallback)(void *, void *))
 {
 	DEBUG_METHOD_CALL("ListCollection::Filter");
@@ -195,9 +556,7 @@ ListElement *ListCollection::GetInternal(bool (*iCallback)(void *, void *))
 {
 	DEBUG_METHOD_CALL("ListCollection::GetInternal");
 
-	int lIterator = 0;
-
-	for (ListElement *lCurrentElement = mFirst; lCurrentElement != nullptr; lCurrentElement = lCurrentElement->mNext, lIterator++)
+	for (ListElement *lCurrentElement : mElements)
 	{
 		// Call customer comparer
 		if (iCallback(lCurrentElement->mObject, mHostingElement))
@@ -222,18 +581,70 @@ uint16_t ListCollection::Count()
 {
 	DEBUG_METHOD_CALL("ListCollection::Count");
 
-	uint16_t lIterator = 0;
+	return mElements.Count();
+}
 
-	for (ListElement *lCurrentElement = mFirst; lCurrentElement != nullptr; lCurrentElement = lCurrentElement->mNext, lIterator++)
-		;
+#if LIST_CONCURRENT
+void ListCollection::BeginRead()
+{
+#if defined(__AVR__)
+	uint8_t lInterruptState = SREG;
+
+	cli();
+	mReaders++;
+	SREG = lInterruptState;
+#else
+	__atomic_add_fetch(&mReaders, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+void ListCollection::EndRead()
+{
+#if defined(__AVR__)
+	uint8_t lInterruptState = SREG;
+
+	cli();
+	mReaders--;
+	SREG = lInterruptState;
+#else
+	__atomic_sub_fetch(&mReaders, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+bool ListCollection::NoReaders()
+{
+#if defined(__AVR__)
+	return mReaders == 0;
+#else
+	// The unlinking must be visible before the readers are counted - a reader starting later cannot reach the element
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return __atomic_load_n(&mReaders, __ATOMIC_SEQ_CST) == 0;
+#endif
+}
 
-	return lIterator;
+void ListCollection::Reclaim()
+{
+	DEBUG_METHOD_CALL("ListCollection::Reclaim");
+
+	// Without active readers nobody stands on a retired element, readers starting later cannot reach them
+	if ((mRetired == nullptr) || !NoReaders())
+	{
+		return;
+	}
+	while (mRetired != nullptr)
+	{
+		ListElement *lNextElement = mRetired->mNextRetired;
+		delete mRetired->mObject;
+		delete mRetired;
+		mRetired = lNextElement;
+	}
 }
+#endif
 
 ListElement *ListCollection::IterateStart()
 {
 	DEBUG_METHOD_CALL("ListCollection::IterateStart");
-	return mFirst;
+	return mElements.GetFirst();
 }
 
 void *ListCollection::Iterate(ListElement **iCurrentElement)
@@ -245,7 +656,7 @@ void *ListCollection::Iterate(ListElement **iCurrentElement)
 	if (*iCurrentElement != nullptr)
 	{
 		lCurrentObject = (*iCurrentElement)->mObject;
-		(*iCurrentElement) = (*iCurrentElement)->mNext;
+		(*iCurrentElement) = ListFollow(&(*iCurrentElement)->mNext);
 		return lCurrentObject;
 	}
 	return nullptr;
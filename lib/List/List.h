@@ -7,21 +7,361 @@
 #ifndef _List_h
 #define _List_h
 
-#include <Arduino.h>
+#include <stdint.h>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Optional features of ListCollection cost RAM in each list or in each element, so each one can be switched off with 0 or on with 1,
+// e.g. -D LIST_KEYS=0. On ARDUINO_AVR_UNO they are off by default.
+#if defined(ARDUINO_AVR_UNO)
+#define LIST_FEATURE_DEFAULT 0
+#else
+#define LIST_FEATURE_DEFAULT 1
+#endif
+// Cursor of the last access and index table for fast access by index
+#ifndef LIST_INDEX
+#define LIST_INDEX LIST_FEATURE_DEFAULT
+#endif
+// Find by key through a hash table
+#ifndef LIST_KEYS
+#define LIST_KEYS LIST_FEATURE_DEFAULT
+#endif
+// Handles for access and removal in constant time - a slot number in each element
+#ifndef LIST_HANDLES
+#define LIST_HANDLES LIST_FEATURE_DEFAULT
+#endif
+// Readers in interrupts or on another core between BeginRead and EndRead - a link for deleted elements in each element
+#ifndef LIST_CONCURRENT
+#define LIST_CONCURRENT LIST_FEATURE_DEFAULT
+#endif
+
+/// <summary>
+/// Stores a link, that readers in interrupts or on another core follow - they see the old or the new link, never a mix of both.
+/// Everything written before is visible to a reader, that sees the new link.
+/// </summary>
+/// <param name="iTarget">Link to change</param>
+/// <param name="iValue">New value of the link</param>
+template <typename P>
+inline void ListPublish(P **iTarget, P *iValue)
+{
+#if defined(__AVR__)
+	// A pointer is written in two steps, so the interrupts are locked for this single store
+	uint8_t lInterruptState = SREG;
+	cli();
+	*(P *volatile *)iTarget = iValue;
+	SREG = lInterruptState;
+	__asm__ __volatile__("" ::: "memory");
+#else
+	__atomic_store_n(iTarget, iValue, __ATOMIC_RELEASE);
+#endif
+}
+
+/// <summary>
+/// Reads a link, that a writer can change at the same time
+/// </summary>
+/// <param name="iSource">Link to read</param>
+/// <returns>Value of the link</returns>
+template <typename P>
+inline P *ListFollow(P *const *iSource)
+{
+#if defined(__AVR__)
+	uint8_t lInterruptState = SREG;
+	P *lValue;
+
+	cli();
+	lValue = *(P *volatile const *)iSource;
+	SREG = lInterruptState;
+	return lValue;
+#else
+	return __atomic_load_n(iSource, __ATOMIC_ACQUIRE);
+#endif
+}
 
 /// <summary>
-/// Class that contains a single list element. Base is a double chained list.
+/// Links of an object in a List. The object derives from the hook, so the list needs no memory of its own.
+/// An object derives from several hooks with different tags to be part of several lists at the same time.
 /// </summary>
-class ListElement
+/// <typeparam name="T">Type of the object</typeparam>
+/// <typeparam name="Tag">Distinguishes the hooks of several lists</typeparam>
+template <typename T, typename Tag = void>
+class ListHook
 {
 public:
-	ListElement *mPrevious = nullptr; // pointer to predecissor - the 1st element has nullptr
-	ListElement *mNext = nullptr;	  // pointer to successor - the last element has nullptr
-	void *mObject = nullptr;		  // pointer to the contained object
+	T *mPrevious = nullptr; // pointer to predecissor - the 1st element has nullptr
+	T *mNext = nullptr;		// pointer to successor - the last element has nullptr
 };
 
 /// <summary>
-/// Provides the functionality for list processing
+/// Double chained list of objects, that contain the links themselves - adding and removing needs no heap and no cast.
+/// The list does not own the objects, removing an object does not delete it.
+/// One writer can add and remove objects, while readers in interrupts or on another core walk forward with GetFirst and GetNext:
+/// a new object is complete before it is linked, and a removed object keeps its link to the successor,
+/// so a reader standing on it continues with the rest of the list. The writer must keep a removed object
+/// until no reader can stand on it any more, see ListCollection::BeginRead.
+/// </summary>
+/// <typeparam name="T">Type of the objects, derived from ListHook&lt;T, Tag&gt;</typeparam>
+/// <typeparam name="Tag">Selects the hook, if the objects are part of several lists</typeparam>
+template <typename T, typename Tag = void>
+class List
+{
+public:
+	typedef ListHook<T, Tag> Hook;
+
+	/// <summary>
+	/// Walks through the list, e.g. with range-for. The iterator moves on before the object is used,
+	/// so the current object can be removed within the loop.
+	/// </summary>
+	class Iterator
+	{
+	public:
+		Iterator(T *iObject) : mObject(iObject), mNext((iObject == nullptr) ? nullptr : static_cast<Hook *>(iObject)->mNext)
+		{
+		}
+
+		T *operator*() const
+		{
+			return mObject;
+		}
+
+		T *operator->() const
+		{
+			return mObject;
+		}
+
+		Iterator &operator++()
+		{
+			mObject = mNext;
+			mNext = (mNext == nullptr) ? nullptr : static_cast<Hook *>(mNext)->mNext;
+			return *this;
+		}
+
+		bool operator!=(const Iterator &iOther) const
+		{
+			return mObject != iOther.mObject;
+		}
+
+	private:
+		T *mObject; // current object, nullptr at the end
+		T *mNext;	// successor of the current object, taken before the current object is used
+	};
+
+	/// <summary>
+	/// Adds an object at the end of the list
+	/// </summary>
+	/// <param name="iObject">Object, that is not part of this list yet</param>
+	/// <returns>True if the object is sucessfully added</returns>
+	bool Add(T *iObject)
+	{
+		Hook *lHook = static_cast<Hook *>(iObject);
+
+		if ((iObject == nullptr) || Contains(iObject))
+		{
+			return false;
+		}
+
+		lHook->mPrevious = mLast;
+		lHook->mNext = nullptr;
+		if (mLast == nullptr)
+		{
+			ListPublish(&mFirst, iObject);
+		}
+		else
+		{
+			ListPublish(&static_cast<Hook *>(mLast)->mNext, iObject);
+		}
+		mLast = iObject;
+		mCount++;
+		return true;
+	}
+
+	/// <summary>
+	/// Removes an object from the list without deleting it
+	/// </summary>
+	/// <param name="iObject">Object of this list</param>
+	/// <returns>True if the object is sucessfully removed</returns>
+	bool Remove(T *iObject)
+	{
+		Hook *lHook = static_cast<Hook *>(iObject);
+
+		if ((iObject == nullptr) || !Contains(iObject))
+		{
+			return false;
+		}
+
+		if (lHook->mPrevious == nullptr)
+		{
+			ListPublish(&mFirst, lHook->mNext);
+		}
+		else
+		{
+			ListPublish(&static_cast<Hook *>(lHook->mPrevious)->mNext, lHook->mNext);
+		}
+		if (lHook->mNext == nullptr)
+		{
+			mLast = lHook->mPrevious;
+		}
+		else
+		{
+			static_cast<Hook *>(lHook->mNext)->mPrevious = lHook->mPrevious;
+		}
+		// The link to the successor is kept for readers standing on the object
+		lHook->mPrevious = nullptr;
+		mCount--;
+		return true;
+	}
+
+	/// <summary>
+	/// Checks in constant time, if an object is linked into this list - an object can be part of one list per hook only
+	/// </summary>
+	/// <param name="iObject">Object to check</param>
+	/// <returns>True if the object is part of the list</returns>
+	bool Contains(T *iObject) const
+	{
+		Hook *lHook = static_cast<Hook *>(iObject);
+
+		return (lHook->mPrevious != nullptr) || (mFirst == iObject);
+	}
+
+	/// <summary>
+	/// Gets the 1st object of the list
+	/// </summary>
+	/// <returns>Object or nullptr, if the list is empty</returns>
+	T *GetFirst() const
+	{
+		return ListFollow(&mFirst);
+	}
+
+	/// <summary>
+	/// Gets the last object of the list
+	/// </summary>
+	/// <returns>Object or nullptr, if the list is empty</returns>
+	T *GetLast() const
+	{
+		return mLast;
+	}
+
+	/// <summary>
+	/// Gets the object after an object of the list
+	/// </summary>
+	/// <param name="iObject">Object of this list</param>
+	/// <returns>Successor or nullptr at the end of the list</returns>
+	static T *GetNext(T *iObject)
+	{
+		return ListFollow(&static_cast<Hook *>(iObject)->mNext);
+	}
+
+	/// <summary>
+	/// Gets the object before an object of the list
+	/// </summary>
+	/// <param name="iObject">Object of this list</param>
+	/// <returns>Predecessor or nullptr at the start of the list</returns>
+	static T *GetPrevious(T *iObject)
+	{
+		return static_cast<Hook *>(iObject)->mPrevious;
+	}
+
+	/// <summary>
+	/// Gets the object at the index - the list is walked from the nearer end
+	/// </summary>
+	/// <param name="iIndex">Index of the object to get</param>
+	/// <returns>Object or nullptr, if the index is out of range</returns>
+	T *Get(int iIndex) const
+	{
+		T *lObject;
+
+		if ((iIndex < 0) || (iIndex >= mCount))
+		{
+			return nullptr;
+		}
+		if (iIndex < mCount / 2)
+		{
+			for (lObject = mFirst; iIndex > 0; iIndex--)
+			{
+				lObject = static_cast<Hook *>(lObject)->mNext;
+			}
+		}
+		else
+		{
+			for (lObject = mLast, iIndex = mCount - 1 - iIndex; iIndex > 0; iIndex--)
+			{
+				lObject = static_cast<Hook *>(lObject)->mPrevious;
+			}
+		}
+		return lObject;
+	}
+
+	/// <summary>
+	/// Gets the number of objects in constant time
+	/// </summary>
+	/// <returns>Size of list</returns>
+	uint16_t Count() const
+	{
+		return mCount;
+	}
+
+	/// <summary>
+	/// Checks, if the list is empty
+	/// </summary>
+	/// <returns>True if there is no object</returns>
+	bool IsEmpty() const
+	{
+		return mFirst == nullptr;
+	}
+
+	Iterator begin() const
+	{
+		return Iterator(mFirst);
+	}
+
+	Iterator end() const
+	{
+		return Iterator(nullptr);
+	}
+
+private:
+	T *mFirst = nullptr;  // pointer to 1st object of the list
+	T *mLast = nullptr;	  // pointer to last object of the list
+	uint16_t mCount = 0; // number of objects
+};
+
+/// <summary>
+/// Class that contains a single list element of a ListCollection. Base is a double chained list.
+/// </summary>
+class ListElement : public ListHook<ListElement>
+{
+public:
+	void *mObject = nullptr; // pointer to the contained object
+#if LIST_HANDLES
+	uint16_t mSlot = 0;		 // slot of the handle + 1, 0 if the element was added without handle
+#endif
+#if LIST_CONCURRENT
+	ListElement *mNextRetired = nullptr; // next deleted element waiting for the readers
+#endif
+};
+
+#if LIST_HANDLES
+/// <summary>
+/// Refers to an element of a ListCollection like a pointer, but a deleted element is detected instead of accessing freed memory.
+/// The generation counts the uses of the slot, so a handle of a deleted element does not match its reused slot.
+/// </summary>
+struct ListHandle
+{
+	uint16_t Slot = 0;		 // slot of the element + 1, 0 is an invalid handle
+	uint16_t Generation = 0; // use of the slot, when the handle was given
+};
+#endif
+
+/// <summary>
+/// Provides the functionality for list processing of untyped objects, that are deleted together with the list.
+/// New code uses List&lt;T&gt; - this class wraps it for compatibility.
+/// Access by index remembers the last position, so loops over the indexes take constant time per step.
+/// Frequent random access builds an index table, that is kept while elements are added at the end.
+/// Interrupts or another core can iterate between BeginRead and EndRead, while the main loop adds and deletes elements:
+/// only single links are changed with locked interrupts, and deleted elements are kept, until no reader is active.
+/// Readers must use IterateStart and Iterate only, all other methods belong to the writer.
+/// Index table, keys, handles and readers are switched by LIST_INDEX, LIST_KEYS, LIST_HANDLES and LIST_CONCURRENT.
 /// </summary>
 class ListCollection
 {
@@ -49,6 +389,16 @@ public:
 	/// <returns>True if element is sucessfully added</returns>
 	bool Add(void *iObject);
 
+#if LIST_HANDLES
+	/// <summary>
+	/// Adds an object to the list and gets a handle for constant time access and removal
+	/// </summary>
+	/// <param name="iObject">Object to add</param>
+	/// <param name="iHandle">Receives the handle of the object</param>
+	/// <returns>True if element is sucessfully added</returns>
+	bool Add(void *iObject, ListHandle *iHandle);
+#endif
+
 	/// <summary>
 	/// Deletes an object from the list
 	/// </summary>
@@ -63,6 +413,15 @@ public:
 	/// <returns>True if element is sucessfully deleted</returns>
 	bool Delete(ListElement *iCurrentElement);
 
+#if LIST_HANDLES
+	/// <summary>
+	/// Deletes an object from the list in constant time
+	/// </summary>
+	/// <param name="iHandle">Handle given by Add</param>
+	/// <returns>True if element is sucessfully deleted, false if the handle is invalid or the object is deleted already</returns>
+	bool Delete(ListHandle iHandle);
+#endif
+
 	/// <summary>
 	/// Gets the 1st object of the list
 	/// </summary>
@@ -82,6 +441,15 @@ public:
 	/// <returns>Object to get</returns>
 	void *Get(int iIndex);
 
+#if LIST_HANDLES
+	/// <summary>
+	/// Gets an object in constant time
+	/// </summary>
+	/// <param name="iHandle">Handle given by Add</param>
+	/// <returns>Object or nullptr, if the handle is invalid or the object is deleted already</returns>
+	void *Get(ListHandle iHandle);
+#endif
+
 	/// <summary>
 	/// Gets the object using a customer filter implementation
 	/// </summary>
@@ -98,12 +466,48 @@ public:
 
 	void SetHostingElement(void *iHostingElement);
 
+#if LIST_KEYS
+	/// <summary>
+	/// Enables Find by a key of the objects. A hash table with open addressing maps the keys to the elements,
+	/// it is kept up to date by Add and Delete. The key of an object must not change while it is part of the list.
+	/// </summary>
+	/// <param name="iKey">Function that gets the key of an object, the keys should be unique</param>
+	/// <param name="iTable">nullptr: the table is allocated and grows on the heap, otherwise a table with fixed capacity, e.g. a static array for AVR</param>
+	/// <param name="iCapacity">Number of entries of iTable, a power of 2 - one entry stays empty</param>
+	/// <returns>False if the capacity is not a power of 2</returns>
+	bool SetKey(uint32_t (*iKey)(void *), ListElement **iTable = nullptr, uint16_t iCapacity = 0);
+
+	/// <summary>
+	/// Gets the object with a key in constant time - if a fixed table is full, the remaining objects are searched one by one
+	/// </summary>
+	/// <param name="iKey">Key calculated by the function given to SetKey</param>
+	/// <returns>Object or nullptr, if no object has the key</returns>
+	void *Find(uint32_t iKey);
+#endif
+
 	/// <summary>
-	/// Calculates the size of the object list
+	/// Gets the size of the object list
 	/// </summary>
 	/// <returns>Size of list</returns>
 	uint16_t Count();
 
+#if LIST_CONCURRENT
+	/// <summary>
+	/// Announces an iteration from an interrupt or another core - deleted elements are kept until EndRead
+	/// </summary>
+	void BeginRead();
+
+	/// <summary>
+	/// Ends an iteration started with BeginRead
+	/// </summary>
+	void EndRead();
+
+	/// <summary>
+	/// Frees the deleted elements, if no reader is active - Add and Delete do this as well
+	/// </summary>
+	void Reclaim();
+#endif
+
 	/// <summary>
 	/// Starts a new iteration
 	/// </summary>The 1st element of the list of list</returns>
@@ -118,8 +522,77 @@ public:
 private:
 	void *mHostingElement;
 
-	ListElement *mFirst = nullptr; // pointer to 1st element of the list
-	ListElement *mLast = nullptr;  // pointer to last element of the list
+	List<ListElement> mElements;	// chain of the elements
+#if LIST_INDEX
+	ListElement *mCursor = nullptr; // element of the last access by index
+	int mCursorIndex = 0;			// index of mCursor
+	ListElement **mIndex = nullptr; // elements by index - the first mIndexCount entries are valid
+	uint16_t mIndexCount = 0;		// number of valid entries of mIndex
+	uint16_t mIndexCapacity = 0;	// size of mIndex
+	uint16_t mWalkedSteps = 0;		// steps walked through the chain since mIndex is outdated
+#endif
+#if LIST_KEYS
+	uint32_t (*mKey)(void *) = nullptr; // gets the key of an object for Find
+	ListElement **mKeyTable = nullptr;	// hash table of the elements by key, empty entries are nullptr
+	uint16_t mKeyCapacity = 0;			// number of entries of mKeyTable, a power of 2
+	uint16_t mKeyCount = 0;				// number of elements in mKeyTable
+	bool mKeyTableFixed = false;		// true: mKeyTable is given by the user and does not grow
+	bool mKeyOverflow = false;			// true: some elements did not fit into mKeyTable
+#endif
+#if LIST_CONCURRENT
+	volatile uint8_t mReaders = 0;		// number of active readers between BeginRead and EndRead
+	ListElement *mRetired = nullptr;	// deleted elements waiting for the readers, chained by mNextRetired
+#endif
+
+#if LIST_HANDLES
+	struct sSlot
+	{
+		ListElement *Element; // element using the slot, nullptr if the slot is free
+		uint16_t Generation;  // counts the uses of the slot
+		uint16_t NextFree;	  // next free slot + 1, if the slot is free
+	};
+	sSlot *mSlots = nullptr;		// slots of the elements added with handle
+	uint16_t mSlotCount = 0;		// number of slots used at least once
+	uint16_t mSlotCapacity = 0;		// size of mSlots
+	uint16_t mFreeSlot = 0;			// 1st free slot + 1, 0 if all used slots are taken
+
+	/// <summary>
+	/// Gets the element of a handle
+	/// </summary>
+	/// <param name="iHandle">Handle given by Add</param>
+	/// <returns>Element or nullptr, if the handle is outdated</returns>
+	ListElement *GetInternal(ListHandle iHandle);
+#endif
+
+#if LIST_CONCURRENT
+	/// <summary>
+	/// Checks, if a reader could still stand on an element, that has just been unlinked
+	/// </summary>
+	/// <returns>True if no reader is active</returns>
+	bool NoReaders();
+#endif
+
+#if LIST_KEYS
+	/// <summary>
+	/// Enters an element into the hash table of the keys
+	/// </summary>
+	/// <param name="iElement">Element of the list</param>
+	void InsertKey(ListElement *iElement);
+
+	/// <summary>
+	/// Removes an element from the hash table of the keys
+	/// </summary>
+	/// <param name="iElement">Element of the list</param>
+	void RemoveKey(ListElement *iElement);
+#endif
+
+#if LIST_INDEX
+	/// <summary>
+	/// Builds the index table again, when walking has cost as much as building - called after each walk through the chain
+	/// </summary>
+	/// <param name="iSteps">Steps of the last walk</param>
+	void UpdateIndex(uint16_t iSteps);
+#endif
 
 	/// <summary>
 	/// Gets the ListElement at the index
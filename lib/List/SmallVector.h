@@ -0,0 +1,219 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Contiguous list with inline storage for lists, that are built once and iterated often
+
+#pragma once
+#ifndef _SmallVector_h
+#define _SmallVector_h
+
+#include <stdint.h>
+
+/// <summary>
+/// List of elements stored side by side, the first N without heap.
+/// Iterating touches consecutive memory instead of chasing pointers like ListCollection,
+/// so it suits lists, that are built at boot and walked on every tick.
+/// </summary>
+/// <typeparam name="T">Type of the elements - they are copied, e.g. pointers or small structs</typeparam>
+/// <typeparam name="N">Number of elements stored inline</typeparam>
+/// <typeparam name="Growable">true: more than N elements are moved to the heap, false: the capacity is fixed to N</typeparam>
+template <typename T, uint16_t N, bool Growable = true>
+class SmallVector
+{
+	static_assert(N > 0, "Inline capacity of a small vector must not be 0");
+
+public:
+	/// <summary>
+	/// Constructor
+	/// </summary>
+	SmallVector()
+	{
+	}
+
+	/// <summary>
+	/// Releases the heap storage, if the elements have grown beyond the inline storage
+	/// </summary>
+	~SmallVector()
+	{
+		if (mElements != mInline)
+		{
+			delete[] mElements;
+		}
+	}
+
+	// The elements may live in the inline storage, so a copy would point into the original
+	SmallVector(const SmallVector &) = delete;
+	SmallVector &operator=(const SmallVector &) = delete;
+
+	/// <summary>
+	/// Adds an element at the end
+	/// </summary>
+	/// <param name="iElement">Element to copy</param>
+	/// <returns>false: the capacity is exhausted and cannot grow</returns>
+	bool Add(const T &iElement)
+	{
+		if ((mCount == mCapacity) && !Grow())
+		{
+			return false;
+		}
+		mElements[mCount++] = iElement;
+		return true;
+	}
+
+	/// <summary>
+	/// Removes an element in constant time - the last element takes its place, so the order changes
+	/// </summary>
+	/// <param name="iIndex">Index of the element</param>
+	/// <returns>false: the index is out of range</returns>
+	bool RemoveSwap(uint16_t iIndex)
+	{
+		if (iIndex >= mCount)
+		{
+			return false;
+		}
+		mElements[iIndex] = mElements[--mCount];
+		return true;
+	}
+
+	/// <summary>
+	/// Removes an element and keeps the order of the others - the following elements move down
+	/// </summary>
+	/// <param name="iIndex">Index of the element</param>
+	/// <returns>false: the index is out of range</returns>
+	bool Remove(uint16_t iIndex)
+	{
+		if (iIndex >= mCount)
+		{
+			return false;
+		}
+		for (mCount--; iIndex < mCount; iIndex++)
+		{
+			mElements[iIndex] = mElements[iIndex + 1];
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Searches an element from the start
+	/// </summary>
+	/// <param name="iElement">Element to search</param>
+	/// <returns>Index of the 1st equal element or -1, if there is none</returns>
+	int IndexOf(const T &iElement) const
+	{
+		for (uint16_t lIndex = 0; lIndex < mCount; lIndex++)
+		{
+			if (mElements[lIndex] == iElement)
+			{
+				return lIndex;
+			}
+		}
+		return -1;
+	}
+
+	/// <summary>
+	/// Removes all elements - heap storage is kept for the next elements
+	/// </summary>
+	void Clear()
+	{
+		mCount = 0;
+	}
+
+	/// <summary>
+	/// Gets the element at the index without range check
+	/// </summary>
+	T &operator[](uint16_t iIndex)
+	{
+		return mElements[iIndex];
+	}
+
+	const T &operator[](uint16_t iIndex) const
+	{
+		return mElements[iIndex];
+	}
+
+	/// <summary>
+	/// Gets the number of elements
+	/// </summary>
+	/// <returns>Number of elements</returns>
+	uint16_t Count() const
+	{
+		return mCount;
+	}
+
+	/// <summary>
+	/// Gets the number of elements, that fit without growing
+	/// </summary>
+	/// <returns>Capacity</returns>
+	uint16_t Capacity() const
+	{
+		return mCapacity;
+	}
+
+	/// <summary>
+	/// Checks, if there is no element
+	/// </summary>
+	/// <returns>true: the list is empty</returns>
+	bool IsEmpty() const
+	{
+		return mCount == 0;
+	}
+
+	T *begin()
+	{
+		return mElements;
+	}
+
+	T *end()
+	{
+		return mElements + mCount;
+	}
+
+	const T *begin() const
+	{
+		return mElements;
+	}
+
+	const T *end() const
+	{
+		return mElements + mCount;
+	}
+
+private:
+	T mInline[N];			// storage of the first N elements
+	T *mElements = mInline; // current storage, inline or on the heap
+	uint16_t mCount = 0;	// number of elements
+	uint16_t mCapacity = N; // size of the current storage
+
+	/// <summary>
+	/// Moves the elements into a storage of double size on the heap
+	/// </summary>
+	/// <returns>false: growing is not allowed or the heap is exhausted</returns>
+	bool Grow()
+	{
+		uint16_t lCapacity = (mCapacity < 0x8000) ? mCapacity * 2 : 0xFFFF;
+		T *lElements;
+
+		if (!Growable || (lCapacity == mCapacity))
+		{
+			return false;
+		}
+		lElements = new T[lCapacity];
+		if (lElements == nullptr)
+		{
+			return false;
+		}
+		for (uint16_t lIndex = 0; lIndex < mCount; lIndex++)
+		{
+			lElements[lIndex] = mElements[lIndex];
+		}
+		if (mElements != mInline)
+		{
+			delete[] mElements;
+		}
+		mElements = lElements;
+		mCapacity = lCapacity;
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,125 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Typed message queue with fixed capacity for passing data between interrupts, tasks and the main loop
+
+#pragma once
+#ifndef _Mailbox_h
+#define _Mailbox_h
+
+#include "TaskHandler.h"
+
+/// <summary>
+/// Queue of messages with fixed capacity, that needs no heap.
+/// One producer and one consumer can use it at the same time without locking interrupts, e.g. a task callback and the main loop.
+/// With an event, each posted message wakes up the tasks subscribed to it, so a consumer task runs only when messages are present.
+/// Without TASKHANDLER_EVENTS the consumer polls the mailbox.
+/// </summary>
+/// <typeparam name="T">Type of the messages - they are copied</typeparam>
+/// <typeparam name="N">Capacity, a power of 2 up to 128</typeparam>
+template <typename T, uint8_t N>
+class Mailbox
+{
+    static_assert((N > 0) && (N <= 128) && ((N & (N - 1)) == 0), "Capacity of a mailbox must be a power of 2 up to 128");
+
+public:
+#if TASKHANDLER_EVENTS
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    /// <param name="iEventId">Event posted for each message, TASKHANDLER_NO_EVENT if the consumer polls</param>
+    Mailbox(uint8_t iEventId = TASKHANDLER_NO_EVENT) : mEventId(iEventId)
+    {
+    }
+
+    /// <summary>
+    /// Lets a task run each time messages are posted - the task is usually a TTriggerOneTime task, that receives all present messages
+    /// </summary>
+    /// <param name="iConsumer">Task receiving the messages</param>
+    void Wake(Task *iConsumer)
+    {
+        if (mEventId != TASKHANDLER_NO_EVENT)
+        {
+            iConsumer->Subscribe(mEventId, Task::eEventPolicy::TCoalesce);
+        }
+    }
+#endif
+
+    /// <summary>
+    /// Adds a message without waiting - can be called from interrupts
+    /// </summary>
+    /// <param name="iMessage">Message to copy into the mailbox</param>
+    /// <returns>false: the mailbox is full, the message is dropped</returns>
+    bool Post(const T &iMessage)
+    {
+        uint8_t lHead = mHead;
+
+        if ((uint8_t)(lHead - mTail) >= N)
+        {
+            return false;
+        }
+        mMessages[lHead & (N - 1)] = iMessage;
+
+        // The message must be complete before the consumer sees the new head
+        __sync_synchronize();
+        mHead = lHead + 1;
+
+#if TASKHANDLER_EVENTS
+        if (mEventId != TASKHANDLER_NO_EVENT)
+        {
+            TaskHandler::GetInstance()->Post(mEventId);
+        }
+#endif
+        return true;
+    }
+
+    /// <summary>
+    /// Takes the oldest message without waiting
+    /// </summary>
+    /// <param name="iMessage">Buffer for the message</param>
+    /// <returns>false: the mailbox is empty</returns>
+    bool Receive(T *iMessage)
+    {
+        uint8_t lTail = mTail;
+
+        if (lTail == mHead)
+        {
+            return false;
+        }
+        __sync_synchronize();
+        *iMessage = mMessages[lTail & (N - 1)];
+
+        // The entry must be copied before the producer can overwrite it
+        __sync_synchronize();
+        mTail = lTail + 1;
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the number of present messages
+    /// </summary>
+    /// <returns>Number of messages</returns>
+    uint8_t Count()
+    {
+        return (uint8_t)(mHead - mTail);
+    }
+
+    /// <summary>
+    /// Checks, if messages are present
+    /// </summary>
+    /// <returns>true: no message is present</returns>
+    bool IsEmpty()
+    {
+        return mHead == mTail;
+    }
+
+private:
+    T mMessages[N];             // Ring buffer of the messages
+    volatile uint8_t mHead = 0; // Number of posted messages, changed by the producer only
+    volatile uint8_t mTail = 0; // Number of received messages, changed by the consumer only
+#if TASKHANDLER_EVENTS
+    uint8_t mEventId;           // Event posted for each message
+#endif
+};
+
+#endif
@@ -13,9 +13,68 @@
 // 28.12.2022: fix bug with timer interrupt for NANO 33 IOT - Stefan Rau
 // 16.07.2023: Use new capabilities of list processing - Stefan Rau
 // 06.10.2024: replace TimerInterrupt_Generic.h by an own implementation. The lib is too complex for only a timed interrupt - Stefan Rau
+// 18.10.2026: hierarchical timing wheel - a tick processes only expiring tasks instead of all tasks - Stefan Rau
+// 18.10.2026: deferred execution mode: the interrupt marks tasks as ready, RunPending calls the callbacks - Stefan Rau
+// 18.10.2026: tickless mode, idle sleep and simulated timer for host builds - Stefan Rau
+// 18.10.2026: optional runtime statistics of tasks and latency histogram of the dispatcher - Stefan Rau
+// 18.10.2026: follow up tasks can wait for several previous tasks - Stefan Rau
+// 18.10.2026: callbacks with context - Stefan Rau
+// 18.10.2026: coroutine tasks - Stefan Rau
+// 18.10.2026: static singleton, optional static task table without heap allocation - Stefan Rau
+// 18.10.2026: host backend in virtual time is selected automatically without Arduino framework - Stefan Rau
+// 18.10.2026: tick mode measures elapsed ticks against micros(), policies for missed periods of cyclic tasks - Stefan Rau
+// 18.10.2026: one-shot timers with microsecond resolution from a preallocated pool - Stefan Rau
+// 18.10.2026: event queue, tasks subscribe to events - Stefan Rau
+// 18.10.2026: phase staggering of cyclic tasks, worst case load of a tick - Stefan Rau
+// 18.10.2026: parallel execution mode on a pool of worker threads for host builds, thread-safe singleton - Stefan Rau
+// 18.10.2026: pause and resume tasks, inspect and tune tasks by remote control - Stefan Rau
+// 18.10.2026: cancel tasks, remove done one-time tasks, reuse removed tasks - Stefan Rau
+// 18.10.2026: worst case execution time of tasks, rate monotonic check of the CPU utilization - Stefan Rau
+// 18.10.2026: timer of ARDUINO_NANO_RP2040_CONNECT, dual core execution mode with tasks pinned to a core - Stefan Rau
+// 18.10.2026: tasks due in the same tick can be paused or cancelled by callbacks of the other tasks - Stefan Rau
+// 18.10.2026: GetTaskList is available again for existing code - Stefan Rau
+// 18.10.2026: prescaler of the tickless timer for long cycle times - Stefan Rau
+// 18.10.2026: done tasks are removed by the main loop only, not by the timer interrupt - Stefan Rau
+// 18.10.2026: phase staggering tries only the phases, that meet different tasks - Stefan Rau
+// 18.10.2026: spinlock of ARDUINO_NANO_RP2040_CONNECT claimed from the SDK - Stefan Rau
+// 18.10.2026: rate monotonic bound counts the same tasks as the utilization - Stefan Rau
+// 18.10.2026: ticks are measured from the start of the task handler, one tick per interrupt, where the timer is not programmed - Stefan Rau
+// 18.10.2026: events, one-shot timers, coroutines and dual core execution can be switched off at compile time, smaller pools on ARDUINO_AVR_UNO - Stefan Rau
+// 18.10.2026: cancelled tasks do not run anymore and release their follow up tasks only once - Stefan Rau
+// 18.10.2026: RunPending does not call tasks handed over to the workers in parallel execution mode - Stefan Rau
+// 18.10.2026: the dispatcher locks the task handler against the workers of the parallel execution mode as well - Stefan Rau
+// 18.10.2026: phase staggering searches a snapshot of the scheduled tasks with unlocked interrupts and tries at most TASKHANDLER_STAGGER_CANDIDATES phases - Stefan Rau
+// 18.10.2026: the statements of coroutines mark their case labels as intended fall through - Stefan Rau
+// 18.10.2026: the schedulability is checked, when cyclic tasks are activated, resumed or restarted - Stefan Rau
 
 #include "TaskHandler.h"
+#ifndef TASKHANDLER_HOST
 #include <Arduino.h>
+#endif
+#include <limits.h>
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+#if defined(TASKHANDLER_HOST) and defined(TASKHANDLER_STATISTICS)
+#include <chrono>
+#endif
+#ifndef TASKHANDLER_HOST
+#include "ErrorHandler.h"
+#endif
+#ifdef TASKHANDLER_HOST
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+#ifdef ARDUINO_NANO_RP2040_CONNECT
+#include <hardware/sync.h>
+#include <pico/multicore.h>
+#include <pico/time.h>
+#endif
+#if TASKHANDLER_DUAL_CORE
+#include "Mailbox.h"
+#endif
 
 // #ifdef ARDUINO_AVR_NANO_EVERY
 // #define USING_16MHZ true
@@ -54,6 +113,141 @@
 
 static TaskHandler *gInstance = nullptr;
 
+// Protects the timing wheel against the timer interrupt. The interrupt state is restored afterwards,
+// so the macros can be used from the main loop as well as from task callbacks running in the interrupt.
+#if defined(ARDUINO_NANO_RP2040_CONNECT)
+// Masking the interrupts excludes the own core only, a hardware spinlock excludes the other core.
+// The spinlock is taken once per core, so the macros can be nested like on the other processors.
+static spin_lock_t *gSpinLock = nullptr; // spinlock claimed by the constructor of the task handler
+static volatile int8_t gLockOwner = -1;	 // core holding the spinlock
+static uint8_t gLockDepth = 0;			 // nesting depth of the owner
+
+static uint32_t TaskHandlerLock()
+{
+	uint32_t lInterruptState = save_and_disable_interrupts();
+	int8_t lCore = get_core_num();
+
+	if (gLockOwner != lCore)
+	{
+		spin_lock_unsafe_blocking(gSpinLock);
+		gLockOwner = lCore;
+	}
+	gLockDepth++;
+	return lInterruptState;
+}
+
+static void TaskHandlerUnlock(uint32_t iInterruptState)
+{
+	if (--gLockDepth == 0)
+	{
+		gLockOwner = -1;
+		spin_unlock_unsafe(gSpinLock);
+	}
+	restore_interrupts(iInterruptState);
+}
+#define TASKHANDLER_LOCK() uint32_t lInterruptState = TaskHandlerLock()
+#define TASKHANDLER_UNLOCK() TaskHandlerUnlock(lInterruptState)
+#elif defined(__AVR__)
+#define TASKHANDLER_LOCK()          \
+	uint8_t lInterruptState = SREG; \
+	cli()
+#define TASKHANDLER_UNLOCK() SREG = lInterruptState
+#elif defined(__arm__)
+#define TASKHANDLER_LOCK()                          \
+	uint32_t lInterruptState = __get_PRIMASK(); \
+	__disable_irq()
+#define TASKHANDLER_UNLOCK() __set_PRIMASK(lInterruptState)
+#elif defined(TASKHANDLER_HOST)
+// Worker threads of the parallel execution mode share the task handler with the simulated interrupt
+static std::recursive_mutex gLock;
+#define TASKHANDLER_LOCK() std::unique_lock<std::recursive_mutex> lInterruptState(gLock)
+#define TASKHANDLER_UNLOCK() lInterruptState.unlock()
+#else
+#define TASKHANDLER_LOCK() noInterrupts()
+#define TASKHANDLER_UNLOCK() interrupts()
+#endif
+
+// Overloads are logged by the error handler, host builds don't have one
+#ifdef TASKHANDLER_HOST
+#define TASKHANDLER_ERROR(iSeverity, iMessage)
+#else
+#define TASKHANDLER_ERROR(iSeverity, iMessage) ERROR_PRINT(Error::eSeverity::iSeverity, iMessage)
+#endif
+
+// Utilization bound n * (2^(1/n) - 1) of the rate monotonic analysis in per mille for n = 1 .. 10 tasks, more tasks converge to ln(2)
+static const uint16_t gRateMonotonicBound[] = {1000, 828, 779, 756, 743, 734, 728, 724, 720, 717};
+#define TASKHANDLER_RATE_MONOTONIC_LIMIT 693
+
+#ifdef TASKHANDLER_STATISTICS
+/// <summary>
+/// Time base of the statistics
+/// </summary>
+/// <returns>Microseconds since an arbitrary start</returns>
+static unsigned long TaskHandlerMicros()
+{
+#ifdef TASKHANDLER_HOST
+	return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+	return micros();
+#endif
+}
+#endif
+
+/////////////////////////////////////////////////////////////
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+// Text definitions
+
+/// <summary>
+/// There is no new EEPROM address required
+/// </summary>
+TextTaskHandler::TextTaskHandler() : TextBase()
+{
+	DEBUG_INSTANTIATION("TextTaskHandler");
+}
+
+TextTaskHandler::~TextTaskHandler()
+{
+	DEBUG_DESTROY("TextTaskHandler");
+}
+
+String TextTaskHandler::GetObjectName()
+{
+	switch (GetLanguage())
+	{
+		TEXTBASE_LANG_E("Task Handler");
+		TEXTBASE_LANG_D("Aufgabenverwaltung");
+	}
+}
+
+String TextTaskHandler::FunctionNameUnknown(char iModuleIdentifyer, char iParameter)
+{
+	switch (GetLanguage())
+	{
+		TEXTBASE_LANG_E("Unknown function: " + String(iModuleIdentifyer) + ":" + String(iParameter));
+		TEXTBASE_LANG_D("Unbekannte Funktion: " + String(iModuleIdentifyer) + ":" + String(iParameter));
+	}
+}
+
+String TextTaskHandler::TaskListDone()
+{
+	switch (GetLanguage())
+	{
+		TEXTBASE_LANG_E("There are no more entries");
+		TEXTBASE_LANG_D("Es gibt keine weiteren Einträge");
+	}
+}
+
+String TextTaskHandler::NoTaskSelected()
+{
+	switch (GetLanguage())
+	{
+		TEXTBASE_LANG_E("No task selected");
+		TEXTBASE_LANG_D("Keine Aufgabe ausgewählt");
+	}
+}
+#endif
+
 /////////////////////////////////////////////////////////////
 
 // Interrupt handler
@@ -61,7 +255,7 @@ static TaskHandler *gInstance = nullptr;
 #ifdef ARDUINO_AVR_NANO_EVERY
 ISR(RTC_CNT_vect)
 {
-	Task::TaskDispatcher();
+	TaskDispatcher();
 }
 #define PROCESSOR_DEFINED
 #endif
@@ -70,7 +264,22 @@ ISR(RTC_CNT_vect)
 #if TASKHANDLER_USE_TIMER == 3
 void TC3_Handler()
 {
-	TaskDispatcher();
+#if TASKHANDLER_ONE_SHOTS
+	// Compare channel 1 is used by the one-shot timers in tickless mode
+	if (TC3->COUNT16.INTFLAG.bit.MC1)
+	{
+		TC3->COUNT16.INTFLAG.bit.MC1 = 1;
+		if (gInstance != nullptr)
+		{
+			gInstance->DispatchOneShots();
+		}
+	}
+#endif
+	if (TC3->COUNT16.INTFLAG.bit.MC0)
+	{
+		TC3->COUNT16.INTFLAG.bit.MC0 = 1;
+		TaskDispatcher();
+	}
 }
 #define PROCESSOR_DEFINED
 #endif
@@ -98,12 +307,29 @@ void TC5_Handler()
 #ifdef ARDUINO_AVR_UNO
 ISR(WDT_vect)
 {
-	Task::TaskDispatcher();
+	TaskDispatcher();
 }
 #define PROCESSOR_DEFINED
 #endif
 
 #ifdef ARDUINO_NANO_RP2040_CONNECT
+// The timer of the SDK calls the dispatcher from an interrupt of the core, that started it
+static repeating_timer_t gTimer;
+static bool gTimerStarted = false;
+
+static bool TimerCallback(repeating_timer_t *iTimer)
+{
+	(void)iTimer;
+
+	TaskDispatcher();
+	return true;
+}
+#define PROCESSOR_DEFINED
+#endif
+
+#ifdef TASKHANDLER_HOST
+// The interrupt is simulated by SimulateTicks and Idle
+#define PROCESSOR_DEFINED
 #endif
 
 #ifndef PROCESSOR_DEFINED
@@ -114,15 +340,345 @@ ISR(WDT_vect)
 
 void TaskDispatcher()
 {
-	Task *lTask;
+	// Only tasks, that expire at the current tick are touched
+	if (gInstance != nullptr)
+	{
+		gInstance->Dispatch();
+	}
+}
+
+/////////////////////////////////////////////////////////////
+
+// Timer backend for the tickless mode: a free running counter measures the elapsed ticks,
+// its compare register is programmed to the next deadline
+
+#if (defined(ARDUINO_SAMD_NANO_33_IOT) and (TASKHANDLER_USE_TIMER == 3)) or defined(TASKHANDLER_HOST)
+// The 16 bit counter counts with 375kHz divided by its prescaler
+static const uint8_t gPrescalerShift[] = {0, 1, 2, 3, 4, 6, 8, 10}; // division of each prescaler setting as power of 2
+static uint8_t gPrescaler = 0;										 // prescaler setting of the counter
+static unsigned long gCountsPerTick = 375;							 // counts of the counter per tick
+
+/// <summary>
+/// Selects the smallest prescaler, that fits a tick into an eighth of the 16 bit counter, so the timer can sleep over several ticks.
+/// Cycle times above 22s are not possible with the slowest prescaler and are limited.
+/// </summary>
+/// <param name="iCycleTimeInMs">Cycle time in milliseconds</param>
+static void TimerScale(unsigned long iCycleTimeInMs)
+{
+	unsigned long lCounts = 375UL * iCycleTimeInMs;
+
+	gPrescaler = 0;
+	while ((gPrescaler < sizeof(gPrescalerShift) - 1) && ((lCounts >> gPrescalerShift[gPrescaler]) > 0x1FFF))
+	{
+		gPrescaler++;
+	}
+	gCountsPerTick = lCounts >> gPrescalerShift[gPrescaler];
+	gCountsPerTick = (gCountsPerTick > 0x1FFF) ? 0x1FFF : ((gCountsPerTick < 1) ? 1 : gCountsPerTick);
+}
+
+/// <summary>
+/// Gets the most ticks, that can be programmed without overrunning the last processed tick
+/// </summary>
+/// <returns>Number of ticks, at least 1</returns>
+static unsigned long TimerMaxTicks()
+{
+	unsigned long lMaxTicks = 0xFFFF / gCountsPerTick - 1;
+
+	return (lMaxTicks < 1) ? 1 : lMaxTicks;
+}
+#endif
+
+#if defined(ARDUINO_SAMD_NANO_33_IOT) and (TASKHANDLER_USE_TIMER == 3)
+#define TASKHANDLER_TICKLESS_TIMER
+static uint16_t gLastCount = 0;	  // counter value of the last processed tick
+static bool gFreeRunning = false; // true: the counter runs free in tickless mode, compare channel 1 is available
+
+static uint16_t TimerReadCount()
+{
+	TC3->COUNT16.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(0x10);
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY)
+		;
+	return TC3->COUNT16.COUNT.reg;
+}
+
+static unsigned long TimerElapsedTicks()
+{
+	unsigned long lTicks = (uint16_t)(TimerReadCount() - gLastCount) / gCountsPerTick;
+
+	gLastCount += lTicks * gCountsPerTick;
+	return lTicks;
+}
+
+static unsigned long TimerProgram(unsigned long iTicks)
+{
+	// The 16 bit counter must not overrun the last processed tick
+	unsigned long lMaxTicks = TimerMaxTicks();
+	uint16_t lCompare;
+
+	iTicks = (iTicks > lMaxTicks) ? lMaxTicks : iTicks;
+	lCompare = gLastCount + iTicks * gCountsPerTick;
+
+	// If the deadline passed already, the interrupt fires as soon as possible
+	if ((uint16_t)(lCompare - TimerReadCount()) > iTicks * gCountsPerTick)
+	{
+		lCompare = TimerReadCount() + 2;
+	}
+	TC3->COUNT16.CC[0].bit.CC = lCompare;
+	return iTicks;
+}
+
+#if TASKHANDLER_ONE_SHOTS
+static void TimerProgramMicros(unsigned long iMicros, bool iEnable)
+{
+	// 375 counts per millisecond divided by the prescaler, half of the 16 bit counter is the longest distance - a longer time is programmed again after the compare
+	unsigned long lCounts = (iMicros > (80000UL << gPrescalerShift[gPrescaler])) ? 0x7FFF : ((iMicros * 3) / 8) >> gPrescalerShift[gPrescaler];
+
+	if (!gFreeRunning || !iEnable)
+	{
+		TC3->COUNT16.INTENCLR.bit.MC1 = 1;
+		return;
+	}
+	TC3->COUNT16.CC[1].bit.CC = TimerReadCount() + ((lCounts < 2) ? 2 : lCounts);
+	TC3->COUNT16.INTENSET.bit.MC1 = 1;
+}
+#endif
+#endif
+
+#ifdef TASKHANDLER_HOST
+#define TASKHANDLER_TICKLESS_TIMER
+static unsigned long gSimulatedTick = 0;	 // simulated hardware time in ticks
+static unsigned long gSimulatedLastTick = 0; // last tick, that was handed over to the task handler
+static unsigned long gSimulatedCompare = 1;	 // tick, at which the simulated timer fires next
+static unsigned long gSimulatedMicros = 0;	 // simulated hardware time in microseconds
+#if TASKHANDLER_ONE_SHOTS
+static unsigned long gSimulatedOneShot = 0;	 // time, at which the simulated compare channel of the one-shot timers fires
+static bool gSimulatedOneShotArmed = false;	 // true: the compare channel of the one-shot timers is enabled
+#endif
+
+static unsigned long TimerElapsedTicks()
+{
+	unsigned long lTicks = gSimulatedTick - gSimulatedLastTick;
+
+	gSimulatedLastTick = gSimulatedTick;
+	return lTicks;
+}
+
+static unsigned long TimerProgram(unsigned long iTicks)
+{
+	// Limit the simulated counter like the 16 bit hardware counter
+	iTicks = (iTicks > TimerMaxTicks()) ? TimerMaxTicks() : iTicks;
+	gSimulatedCompare = gSimulatedLastTick + iTicks;
+	return iTicks;
+}
+
+#if TASKHANDLER_ONE_SHOTS
+static void TimerProgramMicros(unsigned long iMicros, bool iEnable)
+{
+	gSimulatedOneShot = gSimulatedMicros + iMicros;
+	gSimulatedOneShotArmed = iEnable;
+}
+#endif
+#endif
+
+#ifndef TASKHANDLER_TICKLESS_TIMER
+// Without free running counter the timer fires every tick
+static unsigned long TimerElapsedTicks()
+{
+	return 1;
+}
+
+static unsigned long TimerProgram(unsigned long)
+{
+	return 1;
+}
+
+#if TASKHANDLER_ONE_SHOTS
+// One-shot timers are processed by the tick interrupt
+static void TimerProgramMicros(unsigned long, bool)
+{
+}
+#endif
+#endif
+
+// Time base of the tick mode: timer interrupts can be delayed or lost while interrupts are masked.
+// The elapsed ticks are measured against micros(), so lost ticks are processed with the next interrupt.
+#ifdef TASKHANDLER_HOST
+#if TASKHANDLER_ONE_SHOTS
+static unsigned long ClockMicros()
+{
+	return gSimulatedMicros;
+}
+#endif
+
+static void ClockStart()
+{
+}
+
+static unsigned long ClockElapsedTicks(unsigned long)
+{
+	return TimerElapsedTicks();
+}
+#else
+#if TASKHANDLER_ONE_SHOTS
+static unsigned long ClockMicros()
+{
+	return micros();
+}
+#endif
+
+#if (defined(ARDUINO_SAMD_NANO_33_IOT) and (TASKHANDLER_USE_TIMER == 3)) or defined(ARDUINO_NANO_RP2040_CONNECT)
+static unsigned long gClockMicros = 0; // time of the last processed tick
+
+static void ClockStart()
+{
+	gClockMicros = micros();
+}
+
+static unsigned long ClockElapsedTicks(unsigned long iCycleTimeInUs)
+{
+	// Rounding to the nearest tick absorbs the jitter of the interrupt
+	unsigned long lTicks = (micros() - gClockMicros + iCycleTimeInUs / 2) / iCycleTimeInUs;
+
+	gClockMicros += lTicks * iCycleTimeInUs;
+	return lTicks;
+}
+#else
+// SetCycleTimeInMs does not program the timer of these processors yet, it keeps firing with its preset period.
+// Measured against micros() the ticks would not match the interrupts, so each interrupt is one tick.
+static void ClockStart()
+{
+}
+
+static unsigned long ClockElapsedTicks(unsigned long)
+{
+	return 1;
+}
+#endif
+#endif
+
+#ifdef TASKHANDLER_HOST
+// Thread pool of the parallel execution mode: each worker takes tasks from the front of its own queue
+// and steals tasks from the back of the other queues
+struct sWorker
+{
+	std::mutex Lock;		  // protects the queue
+	std::deque<Task *> Queue; // tasks handed over to the worker
+	std::thread Thread;		  // thread of the worker
+};
+static sWorker *gWorkers = nullptr;			   // all workers
+static unsigned int gWorkerCount = 0;		   // number of workers
+static unsigned int gNextWorker = 0;		   // worker getting the next task - changed by the dispatcher only
+static std::mutex gIdleLock;				   // protects the counters and the waiting for them
+static std::condition_variable gWorkAvailable; // wakes up waiting workers
+static std::condition_variable gWorkDone;	   // wakes up WaitForWorkers
+static unsigned long gQueued = 0;			   // tasks handed over, that are not taken by a worker yet
+static unsigned long gInFlight = 0;			   // tasks handed over, that are not done yet
+static bool gStopWorkers = false;			   // true: the workers end, when all queues are empty
+
+static bool WorkerSubmit(Task *iTask)
+{
+	sWorker *lWorker;
+
+	if (gWorkerCount == 0)
+	{
+		return false;
+	}
+
+	// The task is counted first, so a worker reserving it waits only until it is in the queue
+	{
+		std::lock_guard<std::mutex> lLock(gIdleLock);
+		gQueued++;
+		gInFlight++;
+	}
+	lWorker = &gWorkers[gNextWorker++ % gWorkerCount];
+	{
+		std::lock_guard<std::mutex> lLock(lWorker->Lock);
+		lWorker->Queue.push_back(iTask);
+	}
+	gWorkAvailable.notify_one();
+	return true;
+}
+
+static Task *WorkerTake(unsigned int iWorker)
+{
+	for (unsigned int lOffset = 0; lOffset < gWorkerCount; lOffset++)
+	{
+		sWorker *lWorker = &gWorkers[(iWorker + lOffset) % gWorkerCount];
+		std::lock_guard<std::mutex> lLock(lWorker->Lock);
+
+		if (!lWorker->Queue.empty())
+		{
+			Task *lTask;
 
-	for (ListElement *lTaskIterator = TaskHandler::GetInstance()->GetTaskList()->IterateStart(); lTaskIterator != nullptr;)
+			if (lOffset == 0)
+			{
+				lTask = lWorker->Queue.front();
+				lWorker->Queue.pop_front();
+			}
+			else
+			{
+				lTask = lWorker->Queue.back();
+				lWorker->Queue.pop_back();
+			}
+			return lTask;
+		}
+	}
+	return nullptr;
+}
+#endif
+
+#if TASKHANDLER_DUAL_CORE
+// Queues of the dual core execution mode: the dispatcher fills them, RunPending of each core empties its own queue.
+// Both ends are used with the task handler locked, so floating tasks can be balanced by the fill levels.
+static Mailbox<Task *, TASKHANDLER_CORE_QUEUE_SIZE> gCoreQueues[2];
+
+#ifdef TASKHANDLER_HOST
+static thread_local uint8_t gCore = 0;	   // simulated core of the calling thread
+static std::thread gSecondCore;			   // thread simulating the second core
+static std::condition_variable gCoreWake; // wakes up the second core
+static unsigned long gCoreQueued = 0;	   // tasks queued for the second core since it has emptied its queue - protected by gIdleLock
+static bool gStopSecondCore = false;	   // true: the second core ends, when its queue is empty
+
+static uint8_t CurrentCore()
+{
+	return gCore;
+}
+
+static void SecondCoreMain()
+{
+	gCore = 1;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lLock(gIdleLock);
+
+			gCoreWake.wait(lLock, []
+						   { return gStopSecondCore || (gCoreQueued > 0); });
+			if (gCoreQueued == 0)
+			{
+				return;
+			}
+			gCoreQueued = 0;
+		}
+		TaskHandler::GetInstance()->RunPending();
+	}
+}
+#else
+static uint8_t CurrentCore()
+{
+	return get_core_num();
+}
+
+static void SecondCoreMain()
+{
+	for (;;)
 	{
-		// Ping each single task
-		Task *lTask = (Task *)TaskHandler::GetInstance()->GetTaskList()->Iterate(&lTaskIterator);
-		lTask->Process();
+		TaskHandler::GetInstance()->RunPending();
+		__wfe(); // the dispatcher sends an event after queueing a task, an event sent before is not lost
 	}
 }
+#endif
+#endif
 
 /////////////////////////////////////////////////////////////
 
@@ -130,7 +686,15 @@ TaskHandler::TaskHandler()
 {
 	DEBUG_INSTANTIATION("TaskHandler");
 
-	mTaskList = new ListCollection();
+	gInstance = this;
+
+#ifdef ARDUINO_NANO_RP2040_CONNECT
+	// The SDK hands out a spinlock, that no other library uses
+	gSpinLock = spin_lock_init(spin_lock_claim_unused(true));
+#endif
+
+	// Ticks are counted from now on, not from the start of the processor
+	ClockStart();
 
 	// Initialize timer
 #ifdef ARDUINO_AVR_NANO_EVERY
@@ -141,7 +705,36 @@ TaskHandler::TaskHandler()
 TaskHandler::~TaskHandler()
 {
 	DEBUG_DESTROY("TaskHandler");
-	delete mTaskList;
+
+#ifdef TASKHANDLER_HOST
+#if TASKHANDLER_DUAL_CORE
+	StopSecondCore();
+#endif
+	SetWorkerThreads(0);
+#endif
+#ifndef TASKHANDLER_STATIC_TASKS
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		delete mTasks[lIndex];
+	}
+	while (mFreeTasks != nullptr)
+	{
+		Task *lNext = mFreeTasks->mWheelNext;
+		delete mFreeTasks;
+		mFreeTasks = lNext;
+	}
+	while (mFreeFollowUps != nullptr)
+	{
+		Task::sFollowUp *lNext = mFreeFollowUps->Next;
+		delete mFreeFollowUps;
+		mFreeFollowUps = lNext;
+	}
+#endif
+	if (mTaskList != nullptr)
+	{
+		DetachTaskList();
+		delete mTaskList;
+	}
 	// delete lTimer;
 }
 
@@ -149,15 +742,20 @@ TaskHandler *TaskHandler::GetInstance()
 {
 	DEBUG_METHOD_CALL("TaskHandler::GetInstance");
 
-	// Returns a pointer to singleton instance
-	gInstance = (gInstance == nullptr) ? new TaskHandler : gInstance;
-	return gInstance;
+	// Returns a pointer to singleton instance - it is placed in static memory, not on the heap.
+	// A static local variable is initialized only once, also with several threads.
+	static TaskHandler lInstance;
+
+	return &lInstance;
 }
 
-void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs)
+void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs, bool iTickless)
 {
 	DEBUG_METHOD_CALL("TaskHandler::SetCycleTimeInMs");
 
+	mTickless = iTickless;
+	mCycleTimeInUs = iCycleTimeInMs * 1000UL;
+
 	// Initialize hardware timer
 #ifdef ARDUINO_AVR_NANO_EVERY
 // todo
@@ -171,7 +769,7 @@ void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs)
 	PM->APBCMASK.bit.TC3_ = PM_APBCMASK_TC3;
 	TC3->COUNT16.CTRLA.bit.MODE = TC_CTRLA_MODE_COUNT16_Val;
 	TC3->COUNT16.CTRLA.bit.WAVEGEN = TC_CTRLA_WAVEGEN_MPWM_Val;
-	// TC3->COUNT16.CTRLA.bit.PRESCALER = TC_CTRLA_PRESCALER_DIV1_Val;
+	TC3->COUNT16.CTRLA.bit.PRESCALER = TC_CTRLA_PRESCALER_DIV1_Val;
 	TC3->COUNT16.CTRLA.bit.PRESCSYNC = TC_CTRLA_PRESCSYNC_PRESC_Val;
 	TC3->COUNT16.CTRLBSET.bit.DIR = 0;
 	TC3->COUNT16.CTRLBSET.bit.CMD = TC_CTRLBSET_CMD_RETRIGGER_Val;
@@ -179,6 +777,18 @@ void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs)
 	TC3->COUNT16.CC[0].bit.CC = 375;
 	TC3->COUNT16.CC[1].bit.CC = 374;
 	TC3->COUNT16.INTENSET.bit.MC0 = TC_INTENSET_MC0;
+	gPrescaler = 0;
+	gFreeRunning = false;
+	if (iTickless)
+	{
+		// Free running counter, the compare register is moved to the next deadline
+		TimerScale(iCycleTimeInMs);
+		TC3->COUNT16.CTRLA.bit.PRESCALER = gPrescaler;
+		gFreeRunning = true;
+		TC3->COUNT16.CTRLA.bit.WAVEGEN = TC_CTRLA_WAVEGEN_NFRQ_Val;
+		TC3->COUNT16.CC[0].bit.CC = gCountsPerTick;
+		gLastCount = 0;
+	}
 	TC3->COUNT16.CTRLA.bit.ENABLE = TC_CTRLA_ENABLE;
 #endif
 #if TASKHANDLER_USE_TIMER == 4
@@ -199,10 +809,24 @@ void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs)
 // todo
 #endif
 
+#ifdef TASKHANDLER_HOST
+	// The simulated counter has the limits of the counter of ARDUINO_SAMD_NANO_33_IOT
+	TimerScale(iCycleTimeInMs);
+#endif
+
 #ifdef ARDUINO_NANO_RP2040_CONNECT
-// todo
+	if (gTimerStarted)
+	{
+		cancel_repeating_timer(&gTimer);
+	}
+	// A negative delay counts from the start of the previous callback, so the period does not drift
+	gTimerStarted = add_repeating_timer_us(-(int64_t)mCycleTimeInUs, TimerCallback, nullptr, &gTimer);
 #endif
 
+	ClockStart();
+	mProgrammedTick = mTickCount + 1;
+	Reprogram();
+
 	// #ifdef ARDUINO_SAMD_NANO_33_IOT
 	// 	if (lTimer.attachInterruptInterval((float)iCycleTimeInMs * TIMER1_TICKS_FOR_1_MS, TaskDispatcher))
 	// #endif
@@ -218,111 +842,2199 @@ void TaskHandler::SetCycleTimeInMs(unsigned long iCycleTimeInMs)
 	// 		};
 }
 
-ListCollection *TaskHandler::GetTaskList()
+void TaskHandler::Dispatch()
 {
-	return mTaskList;
-}
-
-/////////////////////////////////////////////////////////////
+#if defined(TASKHANDLER_HOST) || TASKHANDLER_DUAL_CORE
+	// The workers or the second core must not change the timing wheel, while the interrupt processes it
+	TASKHANDLER_LOCK();
+#endif
 
-Task::Task(Task::eTaskType iTaskType, int iTicks, void (*iCallback)())
-{
-	DEBUG_INSTANTIATION("Task: iTaskType=" + String(iTaskType) + ",iTicks=" + String(iTicks) + ",iCallback=" + String(iCallback == nullptr ? "nullptr" : "valid"));
+#ifdef TASKHANDLER_STATISTICS
+	unsigned long lEntryMicros = TaskHandlerMicros();
+	unsigned long lExpectedMicros = mLastDispatchMicros + mExpectedTicks * mCycleTimeInUs;
+	unsigned long lLatency = ((long)(lEntryMicros - lExpectedMicros) > 0) ? lEntryMicros - lExpectedMicros : 0;
+	uint8_t lBucket = 0;
 
-	// Initialize task
+	// Sort the latency compared with the expected entry time into a logarithmic histogram
+	while ((lLatency > 1) && (lBucket < TASKHANDLER_LATENCY_BUCKETS - 1))
+	{
+		lLatency >>= 1;
+		lBucket++;
+	}
+	if (mLastDispatchMicros != 0 && mLatencyHistogram[lBucket] < 0xFFFF)
+	{
+		mLatencyHistogram[lBucket]++;
+	}
+	mLastDispatchMicros = lEntryMicros;
+#endif
+
+	unsigned long lElapsed = mTickless ? TimerElapsedTicks() : ClockElapsedTicks(mCycleTimeInUs);
+
+	mDispatching = true;
+	mDispatchTarget = mTickCount + lElapsed;
+
+	// Ticks are processed one by one, so cascading of the wheel keeps working after a long sleep
+	while (lElapsed-- > 0)
+	{
+#ifdef TASKHANDLER_STATISTICS
+		mTickMicros = lEntryMicros - lElapsed * mCycleTimeInUs;
+#endif
+		Tick();
+	}
+
+#if TASKHANDLER_EVENTS
+	// Tasks started by events are scheduled from the current tick, so they expire with the next call at the earliest
+	DispatchEvents();
+#endif
+
+	mDispatching = false;
+	Reprogram();
+
+#if TASKHANDLER_ONE_SHOTS
+	// Without compare channel the one-shot timers expire with the tick
+	DispatchOneShots();
+#endif
+
+	// Done tasks are removed by the main loop, that uses the task table without locking, see Reap
+
+#if defined(TASKHANDLER_HOST) || TASKHANDLER_DUAL_CORE
+	TASKHANDLER_UNLOCK();
+#endif
+
+#ifdef TASKHANDLER_STATISTICS
+	mExpectedTicks = mTickless ? mProgrammedTick - mTickCount : 1;
+#endif
+}
+
+void TaskHandler::Reprogram()
+{
+	if (mTickless)
+	{
+		mProgrammedTick = mTickCount + TimerProgram(GetTicksToNextDeadline());
+	}
+}
+
+unsigned long TaskHandler::GetTicksToNextDeadline()
+{
+	unsigned long lTicks = TASKHANDLER_NO_DEADLINE;
+
+	TASKHANDLER_LOCK();
+
+	// The lowest level contains only tasks, that expire exactly at their slot
+	for (unsigned long lOffset = 1; lOffset < TASKHANDLER_WHEEL_SLOTS; lOffset++)
+	{
+		if (mWheel[0][(mTickCount + lOffset) & TASKHANDLER_WHEEL_MASK] != nullptr)
+		{
+			lTicks = lOffset;
+			break;
+		}
+	}
+
+	// Tasks of higher levels need a wake up, when their slot is cascaded
+	for (int lLevel = 1; lLevel < TASKHANDLER_WHEEL_LEVELS; lLevel++)
+	{
+		int lShift = lLevel * TASKHANDLER_WHEEL_BITS;
+
+		for (unsigned long lOffset = 1; lOffset <= TASKHANDLER_WHEEL_SLOTS; lOffset++)
+		{
+			unsigned long lBlock = (mTickCount >> lShift) + lOffset;
+
+			if (mWheel[lLevel][lBlock & TASKHANDLER_WHEEL_MASK] != nullptr)
+			{
+				unsigned long lCascade = (lBlock << lShift) - mTickCount;
+
+				lTicks = (lCascade < lTicks) ? lCascade : lTicks;
+				break;
+			}
+		}
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	return lTicks;
+}
+
+void TaskHandler::Idle()
+{
+	DEBUG_METHOD_CALL("TaskHandler::Idle");
+
+#ifdef TASKHANDLER_HOST
+	// Jump directly to the next simulated timer event
+#if TASKHANDLER_DUAL_CORE
+	if (mExecutionMode == eExecutionMode::TDualCore)
+	{
+		TASKHANDLER_LOCK();
+		if (!gCoreQueues[CurrentCore()].IsEmpty())
+		{
+			return;
+		}
+		TASKHANDLER_UNLOCK();
+	}
+	else
+#endif
+	{
+		for (uint8_t lWord = 0; lWord < TASKHANDLER_READY_WORDS; lWord++)
+		{
+			if (mReady[lWord] != 0)
+			{
+				return;
+			}
+		}
+	}
+	SimulateTicks((mTickless && ((long)(gSimulatedCompare - gSimulatedTick) > 0)) ? gSimulatedCompare - gSimulatedTick : 1);
+#else
+	bool lPending = false;
+
+	// A ready bit set between checking and sleeping must wake the processor, so the check is done with locked interrupts
+	noInterrupts();
+#if TASKHANDLER_DUAL_CORE
+	// Tasks queued for the other core do not keep this core awake
+	if (mExecutionMode == eExecutionMode::TDualCore)
+	{
+		lPending = !gCoreQueues[CurrentCore()].IsEmpty();
+	}
+	else
+#endif
+	{
+		for (uint8_t lWord = 0; lWord < TASKHANDLER_READY_WORDS; lWord++)
+		{
+			lPending = lPending || (mReady[lWord] != 0);
+		}
+	}
+	if (lPending)
+	{
+		interrupts();
+		return;
+	}
+#if defined(__AVR__)
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu(); // sei delays interrupts until sleep_cpu is executed
+	sleep_disable();
+#elif defined(__arm__)
+	__WFI(); // wakes up on a pending interrupt although interrupts are locked
+	interrupts();
+#else
+	interrupts();
+#endif
+#endif
+}
+
+#ifdef TASKHANDLER_HOST
+void TaskHandler::SimulateTicks(unsigned long iTicks)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SimulateTicks");
+
+	unsigned long lEnd = gSimulatedTick + iTicks;
+
+	while (gSimulatedTick != lEnd)
+	{
+		// Tick mode fires at every tick, tickless mode jumps directly to the programmed compare value
+		bool lFires = !mTickless || ((long)(gSimulatedCompare - gSimulatedTick) <= 0) || ((long)(gSimulatedCompare - lEnd) <= 0);
+		unsigned long lNext = !mTickless || ((long)(gSimulatedCompare - gSimulatedTick) <= 0) ? gSimulatedTick + 1 : (lFires ? gSimulatedCompare : lEnd);
+
+#if TASKHANDLER_ONE_SHOTS
+		// The compare channel of the one-shot timers fires in between
+		while (gSimulatedOneShotArmed && ((long)(gSimulatedOneShot - lNext * mCycleTimeInUs) < 0))
+		{
+			gSimulatedMicros = ((long)(gSimulatedOneShot - gSimulatedMicros) > 0) ? gSimulatedOneShot : gSimulatedMicros;
+			gSimulatedOneShotArmed = false;
+			DispatchOneShots();
+		}
+#endif
+
+		gSimulatedTick = lNext;
+		gSimulatedMicros = lNext * mCycleTimeInUs;
+		if (lFires)
+		{
+			mDispatchCount++;
+			TaskDispatcher();
+		}
+	}
+}
+
+void TaskHandler::SimulateLostTicks(unsigned long iTicks)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SimulateLostTicks");
+
+	gSimulatedTick += iTicks;
+	gSimulatedMicros = gSimulatedTick * mCycleTimeInUs;
+}
+
+void TaskHandler::SetWorkerThreads(unsigned int iThreads)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SetWorkerThreads");
+
+	// Stop the running workers after they have emptied the queues
+	{
+		std::lock_guard<std::mutex> lLock(gIdleLock);
+		gStopWorkers = true;
+	}
+	gWorkAvailable.notify_all();
+	for (unsigned int lWorker = 0; lWorker < gWorkerCount; lWorker++)
+	{
+		gWorkers[lWorker].Thread.join();
+	}
+	delete[] gWorkers;
+	gWorkers = nullptr;
+	gWorkerCount = 0;
+	gStopWorkers = false;
+
+	if (iThreads == 0)
+	{
+		return;
+	}
+	gWorkers = new sWorker[iThreads];
+	gWorkerCount = iThreads;
+	for (unsigned int lWorker = 0; lWorker < iThreads; lWorker++)
+	{
+		gWorkers[lWorker].Thread = std::thread(Worker, lWorker);
+	}
+
+	// Tasks marked as ready without workers are not handed over yet - RunPending does not call them any more
+	if (mExecutionMode == eExecutionMode::TParallel)
+	{
+		TASKHANDLER_LOCK();
+		for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+		{
+			if ((mReady[lIndex / TASKHANDLER_READY_BITS] & (1U << (lIndex % TASKHANDLER_READY_BITS))) != 0)
+			{
+				WorkerSubmit(mTasks[lIndex]);
+			}
+		}
+		TASKHANDLER_UNLOCK();
+	}
+}
+
+void TaskHandler::WaitForWorkers()
+{
+	DEBUG_METHOD_CALL("TaskHandler::WaitForWorkers");
+
+	std::unique_lock<std::mutex> lLock(gIdleLock);
+
+	gWorkDone.wait(lLock, []
+				   { return gInFlight == 0; });
+}
+
+void TaskHandler::Worker(unsigned int iWorker)
+{
+	for (;;)
+	{
+		Task *lTask;
+
+		// Reserve one of the handed over tasks
+		{
+			std::unique_lock<std::mutex> lLock(gIdleLock);
+
+			gWorkAvailable.wait(lLock, []
+								{ return gStopWorkers || (gQueued > 0); });
+			if (gQueued == 0)
+			{
+				return;
+			}
+			gQueued--;
+		}
+
+		// The reserved task is in one of the queues or arrives there immediately
+		while ((lTask = WorkerTake(iWorker)) == nullptr)
+		{
+			std::this_thread::yield();
+		}
+		gInstance->ExecuteParallel(lTask);
+	}
+}
+
+void TaskHandler::ExecuteParallel(Task *iTask)
+{
+	iTask->Execute();
+
+	// The task is handed over again, when it expires next - until then a task runs on one worker only
+	{
+		TASKHANDLER_LOCK();
+		mReady[iTask->mIndex / TASKHANDLER_READY_BITS] &= ~(1U << (iTask->mIndex % TASKHANDLER_READY_BITS));
+		TASKHANDLER_UNLOCK();
+	}
+
+	std::lock_guard<std::mutex> lLock(gIdleLock);
+	if (--gInFlight == 0)
+	{
+		gWorkDone.notify_all();
+	}
+}
+
+#if TASKHANDLER_DUAL_CORE
+void TaskHandler::StopSecondCore()
+{
+	DEBUG_METHOD_CALL("TaskHandler::StopSecondCore");
+
+	if (!mSecondCore)
+	{
+		return;
+	}
+
+	// New tasks are queued for core 0, the tasks queued for the second core are processed before it ends
+	{
+		TASKHANDLER_LOCK();
+		mSecondCore = false;
+		TASKHANDLER_UNLOCK();
+	}
+	{
+		std::lock_guard<std::mutex> lLock(gIdleLock);
+		gStopSecondCore = true;
+	}
+	gCoreWake.notify_all();
+	gSecondCore.join();
+	gStopSecondCore = false;
+}
+#endif
+
+unsigned long TaskHandler::GetDispatchCount()
+{
+	return mDispatchCount;
+}
+
+unsigned long TaskHandler::GetRunCount()
+{
+	return mRunCount;
+}
+#endif
+
+unsigned long TaskHandler::GetTickCount()
+{
+	return mTickCount;
+}
+
+#if TASKHANDLER_ONE_SHOTS
+uint16_t TaskHandler::After(unsigned long iMicros, void (*iCallback)(void *), void *iContext)
+{
+	uint16_t lHandle = TASKHANDLER_NO_ONE_SHOT;
+
+	TASKHANDLER_LOCK();
+
+	for (uint8_t lIndex = 0; lIndex < TASKHANDLER_MAX_ONE_SHOTS; lIndex++)
+	{
+		sOneShot *lOneShot = &mOneShots[lIndex];
+
+		if (!lOneShot->Armed)
+		{
+			lOneShot->DueMicros = ClockMicros() + iMicros;
+			lOneShot->Callback = iCallback;
+			lOneShot->Context = iContext;
+			lOneShot->Generation++;
+			lOneShot->Armed = true;
+			// The handle contains the generation, so a handle of an expired timer does not cancel a reused entry
+			lHandle = ((uint16_t)lOneShot->Generation << 8) | (lIndex + 1);
+			ProgramOneShots();
+			break;
+		}
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	return lHandle;
+}
+#endif
+
+#if TASKHANDLER_EVENTS
+bool TaskHandler::Post(uint8_t iEventId)
+{
+	bool lPosted = false;
+
+	if (iEventId >= TASKHANDLER_MAX_EVENTS)
+	{
+		return false;
+	}
+
+	TASKHANDLER_LOCK();
+
+	if ((uint8_t)(mEventHead - mEventTail) < TASKHANDLER_EVENT_QUEUE_SIZE)
+	{
+		mEvents[mEventHead & TASKHANDLER_EVENT_QUEUE_MASK] = iEventId;
+		mEventHead++;
+		lPosted = true;
+
+		// In tickless mode the timer must fire with the next tick to dispatch the event
+		if (mTickless && !mDispatching && ((mProgrammedTick - mTickCount) > 1))
+		{
+			mProgrammedTick = mTickCount + TimerProgram(1);
+		}
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	return lPosted;
+}
+
+void TaskHandler::DispatchEvents()
+{
+	// Only events posted until now are dispatched, events posted by the started tasks follow with the next call
+	uint8_t lHead = mEventHead;
+
+	while (mEventTail != lHead)
+	{
+		uint8_t lEventId = mEvents[mEventTail & TASKHANDLER_EVENT_QUEUE_MASK];
+
+		mEventTail++;
+		for (Task *lTask = mSubscribers[lEventId]; lTask != nullptr; lTask = lTask->mEventNext)
+		{
+			lTask->Trigger();
+		}
+	}
+}
+#endif
+
+#if TASKHANDLER_ONE_SHOTS
+bool TaskHandler::Cancel(uint16_t iHandle)
+{
+	uint8_t lIndex = (iHandle & 0xFF) - 1;
+	bool lCancelled = false;
+
+	TASKHANDLER_LOCK();
+
+	if ((lIndex < TASKHANDLER_MAX_ONE_SHOTS) && mOneShots[lIndex].Armed && (mOneShots[lIndex].Generation == (iHandle >> 8)))
+	{
+		mOneShots[lIndex].Armed = false;
+		lCancelled = true;
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	return lCancelled;
+}
+
+void TaskHandler::DispatchOneShots()
+{
+	unsigned long lNow = ClockMicros();
+
+	for (uint8_t lIndex = 0; lIndex < TASKHANDLER_MAX_ONE_SHOTS; lIndex++)
+	{
+		sOneShot *lOneShot = &mOneShots[lIndex];
+		void (*lCallback)(void *) = nullptr;
+		void *lContext = nullptr;
+
+		// The entry is released before its callback, so the callback can arm a timer again
+		TASKHANDLER_LOCK();
+		if (lOneShot->Armed && ((long)(lNow - lOneShot->DueMicros) >= 0))
+		{
+			lOneShot->Armed = false;
+			lCallback = lOneShot->Callback;
+			lContext = lOneShot->Context;
+		}
+		TASKHANDLER_UNLOCK();
+
+		if (lCallback != nullptr)
+		{
+			lCallback(lContext);
+		}
+	}
+
+	ProgramOneShots();
+}
+
+void TaskHandler::ProgramOneShots()
+{
+	unsigned long lNow = ClockMicros();
+	unsigned long lNext = 0;
+	bool lArmed = false;
+
+	TASKHANDLER_LOCK();
+
+	for (uint8_t lIndex = 0; lIndex < TASKHANDLER_MAX_ONE_SHOTS; lIndex++)
+	{
+		if (mOneShots[lIndex].Armed)
+		{
+			unsigned long lDistance = ((long)(mOneShots[lIndex].DueMicros - lNow) > 0) ? mOneShots[lIndex].DueMicros - lNow : 0;
+
+			lNext = (!lArmed || (lDistance < lNext)) ? lDistance : lNext;
+			lArmed = true;
+		}
+	}
+	TimerProgramMicros(lNext, lArmed);
+
+	TASKHANDLER_UNLOCK();
+}
+#endif
+
+void TaskHandler::SetExecutionMode(eExecutionMode iExecutionMode)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SetExecutionMode");
+
+	mExecutionMode = iExecutionMode;
+}
+
+void TaskHandler::SetPhaseStaggering(bool iStaggering)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SetPhaseStaggering");
+
+	mPhaseStaggering = iStaggering;
+}
+
+/// <summary>
+/// Calculates the greatest common divisor of two periods
+/// </summary>
+/// <param name="iA">1st period, greater than 0</param>
+/// <param name="iB">2nd period, greater than 0</param>
+/// <returns>Greatest common divisor</returns>
+static unsigned int GreatestCommonDivisor(unsigned int iA, unsigned int iB)
+{
+	while (iB != 0)
+	{
+		unsigned int lRest = iA % iB;
+
+		iA = iB;
+		iB = lRest;
+	}
+	return iA;
+}
+
+// Scheduled task as seen by the phase search of a new cyclic task
+struct sStaggerEntry
+{
+	unsigned int Divisor; // phases, that are equal modulo this divisor, meet the task
+	unsigned int Residue; // phase modulo the divisor, that meets the task
+	unsigned long Limit;  // last phase, that meets the task - ULONG_MAX for cyclic tasks, the others expire only once
+	unsigned long Weight; // weight of the task
+};
+
+void TaskHandler::Restagger()
+{
+	DEBUG_METHOD_CALL("TaskHandler::Restagger");
+
+	Task *lOrder[TASKHANDLER_MAX_TASKS];
+	uint8_t lCount = 0;
+
+	// The timer interrupt must not process the wheel, while the tasks are taken out
+	TASKHANDLER_LOCK();
+
+	// Take all running cyclic tasks out of the wheel, sorted by descending weight
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		Task *lTask = mTasks[lIndex];
+		uint8_t lPosition = lCount;
+
+		if ((lTask->mTaskType != Task::eTaskType::TCyclic) || (lTask->mWheelPrevious == nullptr))
+		{
+			continue;
+		}
+		while ((lPosition > 0) && (GetWeight(lOrder[lPosition - 1]) < GetWeight(lTask)))
+		{
+			lOrder[lPosition] = lOrder[lPosition - 1];
+			lPosition--;
+		}
+		lOrder[lPosition] = lTask;
+		lCount++;
+		Unschedule(lTask);
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	// Expensive tasks are placed first, cheap tasks fill the gaps - each search runs with unlocked interrupts
+	for (uint8_t lIndex = 0; lIndex < lCount; lIndex++)
+	{
+		Stagger(lOrder[lIndex]);
+	}
+}
+
+unsigned long TaskHandler::GetWorstCaseLoad()
+{
+	DEBUG_METHOD_CALL("TaskHandler::GetWorstCaseLoad");
+
+	unsigned long lWorst = 0;
+	// The load repeats after the least common multiple of the periods
+	unsigned long lWindow = GetStaggerWindow(1);
+
+	for (unsigned long lOffset = 1; lOffset <= lWindow; lOffset++)
+	{
+		unsigned long lLoad = GetLoad(mTickCount + lOffset);
+
+		lWorst = (lLoad > lWorst) ? lLoad : lWorst;
+	}
+	return lWorst;
+}
+
+unsigned long TaskHandler::GetUtilization()
+{
+	DEBUG_METHOD_CALL("TaskHandler::GetUtilization");
+
+	unsigned long lUtilization = 0;
+
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		Task *lTask = mTasks[lIndex];
+
+		if (IsUtilizing(lTask))
+		{
+			lUtilization += lTask->mWorstCaseUs * 1000UL / (((lTask->mTicks > 0) ? lTask->mTicks : 1) * mCycleTimeInUs);
+		}
+	}
+	return lUtilization;
+}
+
+bool TaskHandler::IsUtilizing(Task *iTask)
+{
+	return (iTask->mWorstCaseUs > 0) &&
+		   ((iTask->mTaskType == Task::eTaskType::TCyclic) || (iTask->mTaskType == Task::eTaskType::TFollowUpCyclic)) &&
+		   ((iTask->mTaskState == Task::eTaskState::TRunning) || (iTask->mTaskState == Task::eTaskState::TWaiting));
+}
+
+void TaskHandler::SetAdmissionControl(bool iAdmissionControl)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SetAdmissionControl");
+
+	mAdmissionControl = iAdmissionControl;
+}
+
+bool TaskHandler::CheckSchedulability(Task *iTask)
+{
+	DEBUG_METHOD_CALL("TaskHandler::CheckSchedulability");
+
+	unsigned long lUtilization = GetUtilization();
+	uint8_t lCount = 0;
+	unsigned long lBound;
+
+	// The bound depends on the number of tasks, that GetUtilization sums up
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		if (IsUtilizing(mTasks[lIndex]))
+		{
+			lCount++;
+		}
+	}
+	lBound = (lCount == 0) ? 1000 : ((lCount <= sizeof(gRateMonotonicBound) / sizeof(gRateMonotonicBound[0])) ? gRateMonotonicBound[lCount - 1] : TASKHANDLER_RATE_MONOTONIC_LIMIT);
+
+	if (lUtilization > 1000)
+	{
+		// The cyclic tasks need more time than there is, they drift or miss periods
+		TASKHANDLER_ERROR(TError, "Task " + String(iTask->mIndex) + " overloads the CPU: utilization " + String(lUtilization) + " per mille");
+		if (mAdmissionControl)
+		{
+			iTask->Pause();
+		}
+		return false;
+	}
+	if (lUtilization > lBound)
+	{
+		// Above the bound the deadlines can still be met, but this is not guaranteed
+		TASKHANDLER_ERROR(TWarning, "Task " + String(iTask->mIndex) + " exceeds the rate monotonic bound of " + String(lBound) + " per mille: utilization " + String(lUtilization) + " per mille");
+	}
+	return true;
+}
+
+void TaskHandler::Stagger(Task *iTask)
+{
+	sStaggerEntry lEntries[TASKHANDLER_MAX_TASKS];
+	uint8_t lCount = 0;
+	unsigned int lPeriod = (iTask->mTicks > 0) ? iTask->mTicks : 1;
+	unsigned int lCandidates = 1;
+	unsigned int lBestPhase = lPeriod;
+	unsigned long lBestLoad = 0;
+	unsigned long lStartTick;
+
+	// Only the snapshot of the scheduled tasks is taken with locked interrupts, the divisors are calculated once per task
+	{
+		TASKHANDLER_LOCK();
+
+		lStartTick = mTickCount;
+		for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+		{
+			Task *lTask = mTasks[lIndex];
+			unsigned long lDistance = lTask->mDueTick - lStartTick;
+			sStaggerEntry *lEntry = &lEntries[lCount];
+
+			if (lTask->mWheelPrevious == nullptr)
+			{
+				continue;
+			}
+			if ((lTask->mTaskType == Task::eTaskType::TCyclic) || (lTask->mTaskType == Task::eTaskType::TFollowUpCyclic))
+			{
+				unsigned int lOtherPeriod = (lTask->mTicks > 0) ? lTask->mTicks : 1;
+
+				// Two cyclic tasks meet, if their phases are equal modulo the greatest common divisor of their periods.
+				// A scheduled cyclic task expires within its period, so the distance fits the 16 bit modulo.
+				lEntry->Divisor = GreatestCommonDivisor(lPeriod, lOtherPeriod);
+				lEntry->Residue = (lDistance <= lOtherPeriod) ? (unsigned int)lDistance % lEntry->Divisor : lDistance % lEntry->Divisor;
+				lEntry->Limit = ULONG_MAX;
+			}
+			else
+			{
+				lEntry->Divisor = lPeriod;
+				lEntry->Residue = lDistance % lPeriod;
+				lEntry->Limit = lDistance;
+			}
+			lEntry->Weight = GetWeight(lTask);
+			lCount++;
+		}
+
+		TASKHANDLER_UNLOCK();
+	}
+
+	// Phases, that are equal modulo the least common multiple of the divisors, meet the same tasks, so only those are tried
+	for (uint8_t lIndex = 0; (lIndex < lCount) && (lCandidates < TASKHANDLER_STAGGER_CANDIDATES); lIndex++)
+	{
+		if (lEntries[lIndex].Limit == ULONG_MAX)
+		{
+			lCandidates = lCandidates / GreatestCommonDivisor(lCandidates, lEntries[lIndex].Divisor) * lEntries[lIndex].Divisor;
+		}
+	}
+	lCandidates = (lCandidates < TASKHANDLER_STAGGER_CANDIDATES) ? lCandidates : TASKHANDLER_STAGGER_CANDIDATES;
+
+	// The default phase of a full period is kept, if no other phase is better
+	for (unsigned int lCandidate = 0; lCandidate < lCandidates; lCandidate++)
+	{
+		unsigned int lPhase = (lCandidate == 0) ? lPeriod : lCandidate;
+		unsigned long lLoad = 0;
+
+		// Sum of the weights of all tasks, that the task meets with this phase
+		for (uint8_t lIndex = 0; lIndex < lCount; lIndex++)
+		{
+			if ((lPhase % lEntries[lIndex].Divisor == lEntries[lIndex].Residue) && (lPhase <= lEntries[lIndex].Limit))
+			{
+				lLoad += lEntries[lIndex].Weight;
+			}
+		}
+		if ((lCandidate == 0) || (lLoad < lBestLoad))
+		{
+			lBestLoad = lLoad;
+			lBestPhase = lPhase;
+		}
+	}
+
+	// The phase is kept relative to the snapshot, even if ticks passed during the search.
+	// A task cancelled or scheduled meanwhile is left as it is.
+	{
+		TASKHANDLER_LOCK();
+
+		unsigned long lElapsed = mTickCount - lStartTick;
+
+		if ((iTask->mTaskState == Task::eTaskState::TRunning) && (iTask->mWheelPrevious == nullptr))
+		{
+			Schedule(iTask, (lBestPhase > lElapsed) ? lBestPhase - lElapsed : lPeriod - (lElapsed - lBestPhase) % lPeriod);
+		}
+
+		TASKHANDLER_UNLOCK();
+	}
+}
+
+unsigned long TaskHandler::GetLoad(unsigned long iTick)
+{
+	unsigned long lLoad = 0;
+
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		Task *lTask = mTasks[lIndex];
+		unsigned long lDistance = iTick - lTask->mDueTick;
+
+		if ((lTask->mWheelPrevious == nullptr) || ((long)lDistance < 0))
+		{
+			continue;
+		}
+		// Cyclic tasks expire every period after their due tick, all others only at their due tick
+		if ((lTask->mTaskType == Task::eTaskType::TCyclic) || (lTask->mTaskType == Task::eTaskType::TFollowUpCyclic))
+		{
+			lDistance %= (lTask->mTicks > 0) ? lTask->mTicks : 1;
+		}
+		if (lDistance == 0)
+		{
+			lLoad += GetWeight(lTask);
+		}
+	}
+	return lLoad;
+}
+
+unsigned long TaskHandler::GetWeight(Task *iTask)
+{
+	(void)iTask;
+
+#ifdef TASKHANDLER_STATISTICS
+	// Measured tasks count with their average duration, at least 1 microsecond
+	if (iTask->mStatistics.RunCount > 0)
+	{
+		return iTask->mStatistics.TotalExecutionUs / iTask->mStatistics.RunCount + 1;
+	}
+#endif
+	return 1;
+}
+
+unsigned long TaskHandler::GetStaggerWindow(unsigned long iPeriod)
+{
+	unsigned long lWindow = iPeriod;
+
+	for (uint8_t lIndex = 0; (lIndex < mTaskCount) && (lWindow < TASKHANDLER_STAGGER_WINDOW); lIndex++)
+	{
+		Task *lTask = mTasks[lIndex];
+		unsigned long lPeriod = (lTask->mTicks > 0) ? lTask->mTicks : 1;
+
+		if ((lTask->mTaskType != Task::eTaskType::TCyclic) || (lTask->mWheelPrevious == nullptr))
+		{
+			continue;
+		}
+		// Least common multiple by the greatest common divisor - the window is below TASKHANDLER_STAGGER_WINDOW, so it fits the 16 bit modulo
+		lWindow = lWindow / GreatestCommonDivisor(lWindow, lPeriod) * lPeriod;
+	}
+	return (lWindow < TASKHANDLER_STAGGER_WINDOW) ? lWindow : TASKHANDLER_STAGGER_WINDOW;
+}
+
+void TaskHandler::RunPending()
+{
+	DEBUG_METHOD_CALL("TaskHandler::RunPending");
+
+#if TASKHANDLER_DUAL_CORE
+	if (mExecutionMode == eExecutionMode::TDualCore)
+	{
+		uint8_t lCore = CurrentCore();
+
+		for (;;)
+		{
+			Task *lTask;
+			bool lTaken;
+
+			TASKHANDLER_LOCK();
+			lTaken = gCoreQueues[lCore].Receive(&lTask);
+			TASKHANDLER_UNLOCK();
+			if (!lTaken)
+			{
+				break;
+			}
+			ExecuteOnCore(lTask);
+		}
+
+		// The task table belongs to the main loop of the 1st core
+		if (lCore == 0)
+		{
+			Reap();
+		}
+		return;
+	}
+#endif
+
+#ifdef TASKHANDLER_HOST
+	// The marked tasks are handed over to the workers already, the main loop only removes the done tasks
+	if ((mExecutionMode == eExecutionMode::TParallel) && (gWorkerCount > 0))
+	{
+		Reap();
+		return;
+	}
+#endif
+
+	for (uint8_t lWord = 0; lWord < TASKHANDLER_READY_WORDS; lWord++)
+	{
+		for (;;)
+		{
+			unsigned int lBit;
+
+			// Take the lowest ready bit - only that is done with locked interrupts
+			TASKHANDLER_LOCK();
+			if (mReady[lWord] == 0)
+			{
+				TASKHANDLER_UNLOCK();
+				break;
+			}
+			lBit = __builtin_ctz(mReady[lWord]);
+			mReady[lWord] &= ~(1U << lBit);
+			TASKHANDLER_UNLOCK();
+
+			mTasks[lWord * TASKHANDLER_READY_BITS + lBit]->Execute();
+		}
+	}
+
+	Reap();
+}
+
+#if TASKHANDLER_DUAL_CORE
+void TaskHandler::StartSecondCore()
+{
+	DEBUG_METHOD_CALL("TaskHandler::StartSecondCore");
+
+	if (mSecondCore)
+	{
+		return;
+	}
+#ifdef TASKHANDLER_HOST
+	gSecondCore = std::thread(SecondCoreMain);
+#else
+	multicore_launch_core1(SecondCoreMain);
+#endif
+	TASKHANDLER_LOCK();
+	mSecondCore = true;
+	TASKHANDLER_UNLOCK();
+}
+
+void TaskHandler::SubmitToCore(Task *iTask)
+{
+	uint8_t lCore = 0;
+
+	if (mSecondCore)
+	{
+		if (iTask->mCore == Task::eCore::TCore1)
+		{
+			lCore = 1;
+		}
+		else if (iTask->mCore == Task::eCore::TAnyCore)
+		{
+			lCore = (gCoreQueues[0].Count() < gCoreQueues[1].Count()) ? 0 : 1;
+		}
+	}
+
+	if (!gCoreQueues[lCore].Post(iTask))
+	{
+		// Only possible with more tasks than TASKHANDLER_CORE_QUEUE_SIZE - the run is dropped like a skipped period
+		mReady[iTask->mIndex / TASKHANDLER_READY_BITS] &= ~(1U << (iTask->mIndex % TASKHANDLER_READY_BITS));
+		iTask->mMissedPeriods += iTask->mElapsedPeriods;
+		return;
+	}
+
+	if (lCore == 1)
+	{
+#ifdef TASKHANDLER_HOST
+		{
+			std::lock_guard<std::mutex> lLock(gIdleLock);
+			gInFlight++;
+			gCoreQueued++;
+		}
+		gCoreWake.notify_one();
+#else
+		__sev();
+#endif
+	}
+}
+
+void TaskHandler::ExecuteOnCore(Task *iTask)
+{
+	iTask->Execute();
+
+	// The task is queued again, when it expires next - until then a task runs on one core only
+	{
+		TASKHANDLER_LOCK();
+		mReady[iTask->mIndex / TASKHANDLER_READY_BITS] &= ~(1U << (iTask->mIndex % TASKHANDLER_READY_BITS));
+		TASKHANDLER_UNLOCK();
+	}
+
+#ifdef TASKHANDLER_HOST
+	if (CurrentCore() == 1)
+	{
+		std::lock_guard<std::mutex> lLock(gIdleLock);
+		if (--gInFlight == 0)
+		{
+			gWorkDone.notify_all();
+		}
+	}
+#endif
+}
+#endif
+
+void TaskHandler::SetAutoReap(bool iAutoReap)
+{
+	DEBUG_METHOD_CALL("TaskHandler::SetAutoReap");
+
+	mAutoReap = iAutoReap;
+}
+
+uint8_t TaskHandler::GetTaskCount()
+{
+	return mTaskCount;
+}
+
+Task *TaskHandler::GetTask(uint8_t iIndex)
+{
+	return (iIndex < mTaskCount) ? mTasks[iIndex] : nullptr;
+}
+
+ListCollection *TaskHandler::GetTaskList()
+{
+	DEBUG_METHOD_CALL("TaskHandler::GetTaskList");
+
+	if (mTaskList == nullptr)
+	{
+		mTaskList = new ListCollection();
+	}
+	DetachTaskList();
+
+	TASKHANDLER_LOCK();
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		mTaskList->Add(mTasks[lIndex]);
+	}
+	TASKHANDLER_UNLOCK();
+
+	return mTaskList;
+}
+
+void TaskHandler::DetachTaskList()
+{
+	// The tasks belong to the task handler, so the elements are emptied before the list deletes them
+	for (ListElement *lElement = mTaskList->IterateStart(); lElement != nullptr; lElement = mTaskList->IterateStart())
+	{
+		lElement->mObject = nullptr;
+		mTaskList->Delete(lElement);
+	}
+}
+
+#ifdef TASKHANDLER_STATISTICS
+const uint16_t *TaskHandler::GetLatencyHistogram()
+{
+	return mLatencyHistogram;
+}
+
+void TaskHandler::ResetStatistics()
+{
+	DEBUG_METHOD_CALL("TaskHandler::ResetStatistics");
+
+	for (uint8_t lBucket = 0; lBucket < TASKHANDLER_LATENCY_BUCKETS; lBucket++)
+	{
+		mLatencyHistogram[lBucket] = 0;
+	}
+	for (uint8_t lIndex = 0; lIndex < mTaskCount; lIndex++)
+	{
+		mTasks[lIndex]->ResetStatistics();
+	}
+}
+#endif
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+String TaskHandler::DispatchSerial(char iModuleIdentifyer, char iParameter)
+{
+	DEBUG_METHOD_CALL("TaskHandler::DispatchSerial");
+
+	String lReturn = "";
+
+	if ((TaskHandler::eFunctionCode)iModuleIdentifyer != TaskHandler::eFunctionCode::TName)
+	{
+		return lReturn;
+	}
+
+	switch ((TaskHandler::eFunctionCode)iParameter)
+	{
+	case TaskHandler::eFunctionCode::TReadReset:
+		mDispatchIterator = 0;
+		return String(iParameter);
+		break;
+
+	case TaskHandler::eFunctionCode::TInfoNext:
+		if (mDispatchIterator < mTaskCount)
+		{
+			Task *lTask = mTasks[mDispatchIterator];
+
+			// index: type state ticks ticks-to-due pending-events missed-periods
+			mSelectedTask = mDispatchIterator;
+			lReturn = String(mDispatchIterator++) + ": ";
+			lReturn += String((char)lTask->mTaskType) + " ";
+			lReturn += String((char)lTask->mTaskState) + " ";
+			lReturn += String(lTask->mTicks) + " ";
+			lReturn += String((lTask->mWheelPrevious != nullptr) ? (long)(lTask->mDueTick - mTickCount) : -1L) + " ";
+#if TASKHANDLER_EVENTS
+			lReturn += String(lTask->mPendingEvents) + " ";
+#else
+			lReturn += "0 ";
+#endif
+			lReturn += String(lTask->mMissedPeriods);
+			return lReturn;
+		}
+		mSelectedTask = TASKHANDLER_MAX_TASKS;
+		return mText.TaskListDone();
+		break;
+
+	case TaskHandler::eFunctionCode::TPause:
+	case TaskHandler::eFunctionCode::TResume:
+	case TaskHandler::eFunctionCode::TRestart:
+	case TaskHandler::eFunctionCode::TDouble:
+	case TaskHandler::eFunctionCode::THalve:
+	case TaskHandler::eFunctionCode::TIncrease:
+	case TaskHandler::eFunctionCode::TDecrease:
+		if (mSelectedTask >= mTaskCount)
+		{
+			return mText.NoTaskSelected();
+		}
+		switch ((TaskHandler::eFunctionCode)iParameter)
+		{
+		case TaskHandler::eFunctionCode::TPause:
+			mTasks[mSelectedTask]->Pause();
+			break;
+		case TaskHandler::eFunctionCode::TResume:
+			mTasks[mSelectedTask]->Resume();
+			break;
+		case TaskHandler::eFunctionCode::TRestart:
+			mTasks[mSelectedTask]->Restart();
+			break;
+		case TaskHandler::eFunctionCode::TDouble:
+			mTasks[mSelectedTask]->SetTicks(mTasks[mSelectedTask]->GetTicks() * 2);
+			break;
+		case TaskHandler::eFunctionCode::THalve:
+			mTasks[mSelectedTask]->SetTicks(mTasks[mSelectedTask]->GetTicks() / 2);
+			break;
+		case TaskHandler::eFunctionCode::TIncrease:
+			mTasks[mSelectedTask]->SetTicks(mTasks[mSelectedTask]->GetTicks() + 1);
+			break;
+		default:
+			mTasks[mSelectedTask]->SetTicks(mTasks[mSelectedTask]->GetTicks() - 1);
+			break;
+		}
+		// index: state ticks
+		return String(mSelectedTask) + ": " + String((char)mTasks[mSelectedTask]->mTaskState) + " " + String(mTasks[mSelectedTask]->GetTicks());
+		break;
+
+	case TaskHandler::eFunctionCode::TUtilization:
+		return String(GetUtilization());
+		break;
+
+	case TaskHandler::eFunctionCode::TLoad:
+		return String(GetWorstCaseLoad());
+		break;
+
+	case TaskHandler::eFunctionCode::TStagger:
+		Restagger();
+		return String(iParameter);
+		break;
+
+#ifdef TASKHANDLER_STATISTICS
+	case TaskHandler::eFunctionCode::TReadNext:
+		if (mDispatchIterator < mTaskCount)
+		{
+			Task::sStatistics lStatistics = mTasks[mDispatchIterator]->GetStatistics();
+
+			// index: runs min avg max jitter overruns - times in microseconds
+			lReturn = String(mDispatchIterator++) + ": ";
+			lReturn += String(lStatistics.RunCount) + " ";
+			lReturn += String((lStatistics.RunCount > 0) ? lStatistics.MinExecutionUs : 0) + " ";
+			lReturn += String((lStatistics.RunCount > 0) ? lStatistics.TotalExecutionUs / lStatistics.RunCount : 0) + " ";
+			lReturn += String(lStatistics.MaxExecutionUs) + " ";
+			lReturn += String(lStatistics.MaxJitterUs) + " ";
+			lReturn += String(lStatistics.Overruns);
+			return lReturn;
+		}
+		return mText.TaskListDone();
+		break;
+
+	case TaskHandler::eFunctionCode::THistogram:
+		for (uint8_t lBucket = 0; lBucket < TASKHANDLER_LATENCY_BUCKETS; lBucket++)
+		{
+			lReturn += String(mLatencyHistogram[lBucket]);
+			lReturn += (lBucket < TASKHANDLER_LATENCY_BUCKETS - 1) ? " " : "";
+		}
+		return lReturn;
+		break;
+
+	case TaskHandler::eFunctionCode::TClear:
+		ResetStatistics();
+		return String(iParameter);
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+	return mText.FunctionNameUnknown(iModuleIdentifyer, iParameter);
+}
+#endif
+
+bool TaskHandler::Register(Task *iTask)
+{
+	DEBUG_METHOD_CALL("TaskHandler::Register");
+
+	TASKHANDLER_LOCK();
+
+	if (mTaskCount >= TASKHANDLER_MAX_TASKS)
+	{
+		TASKHANDLER_UNLOCK();
+		DEBUG_PRINT_LN("Task table is full");
+		return false;
+	}
+
+	iTask->mIndex = mTaskCount;
+	mTasks[mTaskCount++] = iTask;
+
+	TASKHANDLER_UNLOCK();
+	return true;
+}
+
+Task *TaskHandler::AllocateTask()
+{
+	DEBUG_METHOD_CALL("TaskHandler::AllocateTask");
+
+	Task *lTask = nullptr;
+
+	// Removed tasks are reused first
+	Reap();
+	TASKHANDLER_LOCK();
+	if (mFreeTasks != nullptr)
+	{
+		lTask = mFreeTasks;
+		mFreeTasks = lTask->mWheelNext;
+		lTask->mWheelNext = nullptr;
+	}
+	TASKHANDLER_UNLOCK();
+	if (lTask != nullptr)
+	{
+		return lTask;
+	}
+
+#ifdef TASKHANDLER_STATIC_TASKS
+	if (mTaskPoolCount >= TASKHANDLER_MAX_TASKS)
+	{
+		DEBUG_PRINT_LN("Task table is full");
+		return nullptr;
+	}
+	return &mTaskPool[mTaskPoolCount++];
+#else
+	return new Task();
+#endif
+}
+
+void TaskHandler::FreeTask(Task *iTask)
+{
+	TASKHANDLER_LOCK();
+	// The task is not scheduled any more, so its wheel link chains the removed tasks
+	iTask->mWheelNext = mFreeTasks;
+	mFreeTasks = iTask;
+	TASKHANDLER_UNLOCK();
+}
+
+Task::sFollowUp *TaskHandler::AllocateFollowUp()
+{
+	DEBUG_METHOD_CALL("TaskHandler::AllocateFollowUp");
+
+	Task::sFollowUp *lFollowUp = nullptr;
+
+	TASKHANDLER_LOCK();
+	if (mFreeFollowUps != nullptr)
+	{
+		lFollowUp = mFreeFollowUps;
+		mFreeFollowUps = lFollowUp->Next;
+	}
+	TASKHANDLER_UNLOCK();
+	if (lFollowUp != nullptr)
+	{
+		return lFollowUp;
+	}
+
+#ifdef TASKHANDLER_STATIC_TASKS
+	if (mFollowUpCount >= TASKHANDLER_MAX_FOLLOW_UPS)
+	{
+		DEBUG_PRINT_LN("Table of follow ups is full");
+		return nullptr;
+	}
+	return &mFollowUpPool[mFollowUpCount++];
+#else
+	return new Task::sFollowUp;
+#endif
+}
+
+void TaskHandler::FreeFollowUp(Task::sFollowUp *iFollowUp)
+{
+	TASKHANDLER_LOCK();
+	iFollowUp->Next = mFreeFollowUps;
+	mFreeFollowUps = iFollowUp;
+	TASKHANDLER_UNLOCK();
+}
+
+void TaskHandler::Reap()
+{
+	TASKHANDLER_LOCK();
+
+	// The highest index is removed first, so the last task moved into a free index is never one to be removed now
+	for (int lWord = TASKHANDLER_READY_WORDS - 1; lWord >= 0; lWord--)
+	{
+		// Tasks marked as ready are removed after their run
+		unsigned int lPending = mReap[lWord] & ~mReady[lWord];
+
+		while (lPending != 0)
+		{
+			unsigned int lBit = TASKHANDLER_READY_BITS - 1 - __builtin_clz(lPending);
+
+			lPending &= ~(1U << lBit);
+			mReap[lWord] &= ~(1U << lBit);
+			Remove(lWord * TASKHANDLER_READY_BITS + lBit);
+		}
+	}
+
+	TASKHANDLER_UNLOCK();
+}
+
+void TaskHandler::Remove(uint8_t iIndex)
+{
+	DEBUG_METHOD_CALL("TaskHandler::Remove");
+
+	Task *lTask = mTasks[iIndex];
+	uint8_t lLast = mTaskCount - 1;
+	unsigned int lMask = 1U << (iIndex % TASKHANDLER_READY_BITS);
+	unsigned int lLastMask = 1U << (lLast % TASKHANDLER_READY_BITS);
+
+	Unschedule(lTask);
+#if TASKHANDLER_EVENTS
+	lTask->Subscribe(TASKHANDLER_NO_EVENT, Task::eEventPolicy::TCoalesce);
+#endif
+
+	while (lTask->mFollowUps != nullptr)
+	{
+		Task::sFollowUp *lNext = lTask->mFollowUps->Next;
+		FreeFollowUp(lTask->mFollowUps);
+		lTask->mFollowUps = lNext;
+	}
+
+	// The removed task does not wait for other tasks
+	for (uint8_t lOther = 0; lOther < mTaskCount; lOther++)
+	{
+		Task::sFollowUp **lLink = &mTasks[lOther]->mFollowUps;
+
+		while (*lLink != nullptr)
+		{
+			if ((*lLink)->FollowUp == lTask)
+			{
+				Task::sFollowUp *lEdge = *lLink;
+				*lLink = lEdge->Next;
+				FreeFollowUp(lEdge);
+			}
+			else
+			{
+				lLink = &(*lLink)->Next;
+			}
+		}
+	}
+
+	// The last task takes the index of the removed task together with its marks
+	mReady[iIndex / TASKHANDLER_READY_BITS] &= ~lMask;
+	mReap[iIndex / TASKHANDLER_READY_BITS] &= ~lMask;
+	if (iIndex != lLast)
+	{
+		mTasks[iIndex] = mTasks[lLast];
+		mTasks[iIndex]->mIndex = iIndex;
+		if (mReady[lLast / TASKHANDLER_READY_BITS] & lLastMask)
+		{
+			mReady[iIndex / TASKHANDLER_READY_BITS] |= lMask;
+		}
+		if (mReap[lLast / TASKHANDLER_READY_BITS] & lLastMask)
+		{
+			mReap[iIndex / TASKHANDLER_READY_BITS] |= lMask;
+		}
+		mReady[lLast / TASKHANDLER_READY_BITS] &= ~lLastMask;
+		mReap[lLast / TASKHANDLER_READY_BITS] &= ~lLastMask;
+	}
+	mTasks[lLast] = nullptr;
+	mTaskCount--;
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+	mSelectedTask = TASKHANDLER_MAX_TASKS;
+#endif
+
+	FreeTask(lTask);
+}
+
+void TaskHandler::MarkReady(uint8_t iIndex)
+{
+	mReady[iIndex / TASKHANDLER_READY_BITS] |= 1U << (iIndex % TASKHANDLER_READY_BITS);
+}
+
+void TaskHandler::Tick()
+{
+	Task *lTask;
+	unsigned long lNow = mTickCount + 1;
+	int lSlot = lNow & TASKHANDLER_WHEEL_MASK;
+
+	mTickCount = lNow;
+
+	// Each time a level wraps around, the next slot of the level above is moved down
+	for (int lLevel = 1; (lLevel < TASKHANDLER_WHEEL_LEVELS) && (((lNow >> ((lLevel - 1) * TASKHANDLER_WHEEL_BITS)) & TASKHANDLER_WHEEL_MASK) == 0); lLevel++)
+	{
+		Cascade(lLevel, (lNow >> (lLevel * TASKHANDLER_WHEEL_BITS)) & TASKHANDLER_WHEEL_MASK);
+	}
+
+	// Detach the current slot, so callbacks can schedule tasks again while it is processed.
+	// The chain stays linked to mExpiring, so a callback unscheduling a task further down unlinks it there.
+	mExpiring = mWheel[0][lSlot];
+	mWheel[0][lSlot] = nullptr;
+	if (mExpiring != nullptr)
+	{
+		mExpiring->mWheelPrevious = &mExpiring;
+	}
+
+	while ((lTask = mExpiring) != nullptr)
+	{
+		Unschedule(lTask);
+
+		if (lTask->mDueTick == lNow)
+		{
+			lTask->Process();
+		}
+		else
+		{
+			Link(lTask);
+		}
+	}
+}
+
+void TaskHandler::Schedule(Task *iTask, int iTicks)
+{
+	TASKHANDLER_LOCK();
+
+	Unschedule(iTask);
+	// A task expires at least at the next tick
+	iTask->mDueTick = mTickCount + ((iTicks > 0) ? iTicks : 1);
+	Link(iTask);
+
+	// In tickless mode the timer must fire earlier, if the new task expires before the programmed deadline
+	if (mTickless && !mDispatching && ((iTask->mDueTick - mTickCount) < (mProgrammedTick - mTickCount)))
+	{
+		Reprogram();
+	}
+
+	TASKHANDLER_UNLOCK();
+}
+
+void TaskHandler::Unschedule(Task *iTask)
+{
+	TASKHANDLER_LOCK();
+
+	if (iTask->mWheelPrevious != nullptr)
+	{
+		// Unlink in O(1): the predecessor link points directly to this task
+		*iTask->mWheelPrevious = iTask->mWheelNext;
+		if (iTask->mWheelNext != nullptr)
+		{
+			iTask->mWheelNext->mWheelPrevious = iTask->mWheelPrevious;
+		}
+		iTask->mWheelNext = nullptr;
+		iTask->mWheelPrevious = nullptr;
+	}
+
+	TASKHANDLER_UNLOCK();
+}
+
+void TaskHandler::Link(Task *iTask)
+{
+	unsigned long lDueTick = iTask->mDueTick;
+	unsigned long lDelta = lDueTick - mTickCount;
+	int lLevel = 0;
+	Task **lSlot;
+
+	// Find the lowest level, that covers the distance to the due tick
+	while ((lLevel < TASKHANDLER_WHEEL_LEVELS - 1) && (lDelta >= (1UL << ((lLevel + 1) * TASKHANDLER_WHEEL_BITS))))
+	{
+		lLevel++;
+	}
+
+	// Delays beyond the top level are parked in its last reachable slot and cascaded again later
+	if (lDelta >= (1UL << (TASKHANDLER_WHEEL_LEVELS * TASKHANDLER_WHEEL_BITS)))
+	{
+		lDueTick = mTickCount + (1UL << (TASKHANDLER_WHEEL_LEVELS * TASKHANDLER_WHEEL_BITS)) - 1;
+	}
+
+	lSlot = &mWheel[lLevel][(lDueTick >> (lLevel * TASKHANDLER_WHEEL_BITS)) & TASKHANDLER_WHEEL_MASK];
+
+	// Insert at the head of the slot
+	iTask->mWheelNext = *lSlot;
+	iTask->mWheelPrevious = lSlot;
+	if (*lSlot != nullptr)
+	{
+		(*lSlot)->mWheelPrevious = &iTask->mWheelNext;
+	}
+	*lSlot = iTask;
+}
+
+void TaskHandler::Cascade(int iLevel, int iSlot)
+{
+	Task *lTask = mWheel[iLevel][iSlot];
+
+	mWheel[iLevel][iSlot] = nullptr;
+
+	while (lTask != nullptr)
+	{
+		Task *lNext = lTask->mWheelNext;
+
+		Link(lTask);
+		lTask = lNext;
+	}
+}
+
+/////////////////////////////////////////////////////////////
+
+Task::Task()
+{
+}
+
+Task::~Task()
+{
+	DEBUG_DESTROY("Task");
+
+#ifndef TASKHANDLER_STATIC_TASKS
+	while (mFollowUps != nullptr)
+	{
+		sFollowUp *lNext = mFollowUps->Next;
+		delete mFollowUps;
+		mFollowUps = lNext;
+	}
+#endif
+}
+
+void Task::Initialize(Task::eTaskType iTaskType, int iTicks, void (*iCallback)())
+{
+	DEBUG_INSTANTIATION("Task: iTaskType=" + String((char)iTaskType) + ",iTicks=" + String(iTicks) + ",iCallback=" + String(iCallback == nullptr ? "nullptr" : "valid"));
+
+	// Initialize task
 	mTaskType = iTaskType;
 	mTicks = iTicks;
-	mTaskCounter = mTicks;
+	mPausedState = Task::eTaskState::TWaiting;
+	mDueTick = 0;
+	mIndex = 0;
+#ifdef TASKHANDLER_STATISTICS
+	ResetStatistics();
+	mReleaseMicros = 0;
+#endif
 	if (iTaskType == Task::eTaskType::TTriggerOneTime)
 	{
-		mTaskState = Task::eTaskState::TWaiting;
+		mTaskState = Task::eTaskState::TWaiting;
+	}
+	else
+	{
+		mTaskState = Task::eTaskState::TRunning;
+	}
+	mCallback.Plain = iCallback;
+	mContext = nullptr;
+	mHasContext = false;
+#if TASKHANDLER_COROUTINES
+	mSuspended = false;
+	mResumePoint = 0;
+#endif
+	mMissedTickPolicy = Task::eMissedTickPolicy::TCatchUp;
+	mElapsedPeriods = 1;
+	mMissedPeriods = 0;
+	mWorstCaseUs = 0;
+#if TASKHANDLER_DUAL_CORE
+	mCore = Task::eCore::TAnyCore;
+#endif
+#if TASKHANDLER_EVENTS
+	mEventId = TASKHANDLER_NO_EVENT;
+	mEventPolicy = Task::eEventPolicy::TCoalesce;
+	mPendingEvents = 0;
+	mEventNext = nullptr;
+#endif
+	mWheelNext = nullptr;
+	mWheelPrevious = nullptr;
+	mFollowUps = nullptr;
+	mPendingPrevious = 0;
+}
+
+Task *Task::Create(eTaskType iTaskType, int iTicks, void (*iCallback)())
+{
+	DEBUG_METHOD_CALL("Task::Create");
+
+	Task *lTask = TaskHandler::GetInstance()->AllocateTask();
+
+	if (lTask != nullptr)
+	{
+		lTask->Initialize(iTaskType, iTicks, iCallback);
+	}
+	return lTask;
+}
+
+Task *Task::GetNewTask(eTaskType iTaskType, int iTicks, void (*iCallback)(void))
+{
+	DEBUG_METHOD_CALL("Task::GetNewTask");
+
+	return Activate(Create(iTaskType, iTicks, iCallback));
+}
+
+Task *Task::GetNewTask(eTaskType iTaskType, int iTicks, void (*iCallback)(void *), void *iContext)
+{
+	DEBUG_METHOD_CALL("Task::GetNewTask");
+
+	Task *lTask = Create(iTaskType, iTicks, nullptr);
+
+	if (lTask != nullptr)
+	{
+		lTask->mCallback.WithContext = iCallback;
+		lTask->mContext = iContext;
+		lTask->mHasContext = true;
+	}
+
+	return Activate(lTask);
+}
+
+#if TASKHANDLER_COROUTINES
+Task *Task::GetNewCoroutine(int iTicks, void (*iCoroutine)(Task *, void *), void *iContext)
+{
+	DEBUG_METHOD_CALL("Task::GetNewCoroutine");
+
+	Task *lTask = Create(Task::eTaskType::TCoroutine, iTicks, nullptr);
+
+	if (lTask != nullptr)
+	{
+		lTask->mCallback.Coroutine = iCoroutine;
+		lTask->mContext = iContext;
+		lTask->mHasContext = true;
+	}
+
+	return Activate(lTask);
+}
+#endif
+
+Task *Task::Activate(Task *iTask)
+{
+	DEBUG_METHOD_CALL("Task::Activate");
+
+	if (iTask == nullptr)
+	{
+		return nullptr;
+	}
+
+	// add to task table
+	if (!TaskHandler::GetInstance()->Register(iTask))
+	{
+		TaskHandler::GetInstance()->FreeTask(iTask);
+		return nullptr;
+	}
+
+	// Running tasks start counting immediately, triggered tasks wait for Start
+	if ((iTask->mTaskState == Task::eTaskState::TRunning) && (iTask->mTaskType == Task::eTaskType::TCyclic) && TaskHandler::GetInstance()->mPhaseStaggering)
+	{
+		TaskHandler::GetInstance()->Stagger(iTask);
+	}
+	else if (iTask->mTaskState == Task::eTaskState::TRunning)
+	{
+		TaskHandler::GetInstance()->Schedule(iTask, iTask->mTicks);
+	}
+
+	// A cyclic task with known worst case execution time adds to the utilization
+	if (TaskHandler::GetInstance()->IsUtilizing(iTask))
+	{
+		TaskHandler::GetInstance()->CheckSchedulability(iTask);
+	}
+
+	return iTask;
+}
+
+void Task::Process()
+{
+	DEBUG_METHOD_CALL("Task::Process");
+
+	// Process a single task - the task handler calls it only, when the due tick is reached
+
+	// Check if the task is done or waiting for a trigger
+	if (mTaskState != Task::eTaskState::TRunning)
+	{
+		return;
+	}
+
+	unsigned int lPeriods = 1;
+
+	// Restart a cyclic task before its callback - the period counts from the due tick, so no time is lost
+	if ((mTaskType == Task::eTaskType::TCyclic) || (mTaskType == Task::eTaskType::TFollowUpCyclic))
+	{
+		unsigned long lPeriod = (mTicks > 0) ? mTicks : 1;
+		// Periods, that passed completely until the end of the current dispatcher call, are missed
+		unsigned long lMissed = (TaskHandler::GetInstance()->mDispatchTarget - mDueTick) / lPeriod;
+
+		if (mMissedTickPolicy == Task::eMissedTickPolicy::TCatchUp)
+		{
+			// Missed periods expire again during the same dispatcher call
+			lMissed = 0;
+		}
+		else if (mMissedTickPolicy == Task::eMissedTickPolicy::TSkip)
+		{
+			mMissedPeriods += lMissed;
+		}
+		else
+		{
+			lPeriods += lMissed;
+		}
+		mDueTick += (lMissed + 1) * lPeriod;
+		TaskHandler::GetInstance()->Link(this);
+	}
+
+#ifdef TASKHANDLER_STATISTICS
+	mReleaseMicros = TaskHandler::GetInstance()->mTickMicros;
+#endif
+
+	if (TaskHandler::GetInstance()->mExecutionMode != TaskHandler::eExecutionMode::TImmediate)
+	{
+		bool lMarked = (TaskHandler::GetInstance()->mReady[mIndex / TASKHANDLER_READY_BITS] & (1U << (mIndex % TASKHANDLER_READY_BITS))) != 0;
+
+#ifdef TASKHANDLER_STATISTICS
+		// A task, that is still marked, missed its period
+		if (lMarked)
+		{
+			mStatistics.Overruns++;
+		}
+#endif
+		// The callback is called later by RunPending - a task, that is still marked, runs only once and covers all its periods
+		if (lMarked)
+		{
+			lPeriods += mElapsedPeriods;
+		}
+		mElapsedPeriods = lPeriods;
+		TaskHandler::GetInstance()->MarkReady(mIndex);
+#ifdef TASKHANDLER_HOST
+		// In parallel execution mode a worker calls the callback, a marked task is queued or running already
+		if ((TaskHandler::GetInstance()->mExecutionMode == TaskHandler::eExecutionMode::TParallel) && !lMarked)
+		{
+			WorkerSubmit(this);
+		}
+#endif
+#if TASKHANDLER_DUAL_CORE
+		// In dual core execution mode the task is queued for its core, a marked task is queued or running already
+		if ((TaskHandler::GetInstance()->mExecutionMode == TaskHandler::eExecutionMode::TDualCore) && !lMarked)
+		{
+			TaskHandler::GetInstance()->SubmitToCore(this);
+		}
+#endif
+		return;
+	}
+
+	mElapsedPeriods = lPeriods;
+	Execute();
+}
+
+void Task::Execute()
+{
+	DEBUG_METHOD_CALL("Task::Execute");
+
+	// A task paused or cancelled after it was marked as ready does not run
+	if ((mTaskState == Task::eTaskState::TPaused) || IsEnded())
+	{
+		return;
+	}
+
+#ifdef TASKHANDLER_STATISTICS
+	unsigned long lStartMicros = TaskHandlerMicros();
+	unsigned long lDuration;
+#endif
+
+#if TASKHANDLER_EVENTS
+	// This run covers all merged events posted until now
+	if (mEventPolicy == Task::eEventPolicy::TCoalesce)
+	{
+		mPendingEvents = 0;
+	}
+#endif
+
+	// Call registered task handler
+#if TASKHANDLER_COROUTINES
+	if (mTaskType == Task::eTaskType::TCoroutine)
+	{
+		mSuspended = false;
+		mCallback.Coroutine(this, mContext);
 	}
 	else
+#endif
+	if (mHasContext)
 	{
-		mTaskState = Task::eTaskState::TRunning;
+		mCallback.WithContext(mContext);
+	}
+	else
+	{
+		mCallback.Plain();
+	}
+
+#ifdef TASKHANDLER_STATISTICS
+	lDuration = TaskHandlerMicros() - lStartMicros;
+	mStatistics.RunCount++;
+	mStatistics.TotalExecutionUs += lDuration;
+	mStatistics.MinExecutionUs = (lDuration < mStatistics.MinExecutionUs) ? lDuration : mStatistics.MinExecutionUs;
+	mStatistics.MaxExecutionUs = (lDuration > mStatistics.MaxExecutionUs) ? lDuration : mStatistics.MaxExecutionUs;
+	if ((long)(lStartMicros - mReleaseMicros) > (long)mStatistics.MaxJitterUs)
+	{
+		mStatistics.MaxJitterUs = lStartMicros - mReleaseMicros;
+	}
+	if (lDuration > (unsigned long)((mTicks > 0) ? mTicks : 1) * TaskHandler::GetInstance()->mCycleTimeInUs)
+	{
+		mStatistics.Overruns++;
+	}
+#endif
+
+	// The state is changed with locked interrupts, so the dispatcher or other workers see a finished run only
+	TASKHANDLER_LOCK();
+
+#ifdef TASKHANDLER_HOST
+	TaskHandler::GetInstance()->mRunCount++;
+#endif
+
+	// A task cancelled by its own callback or meanwhile by another one has released its follow up tasks already
+	if (IsEnded())
+	{
+		TASKHANDLER_UNLOCK();
+		return;
+	}
+
+	switch (mTaskType)
+	{
+	case Task::eTaskType::TCyclic:
+	case Task::eTaskType::TFollowUpCyclic:
+		// Cyclic tasks are already scheduled again
+		break;
+
+	case Task::eTaskType::TTriggerOneTime:
+		// Set a startable task to waiting, events arrived in the meantime start it again
+		mTaskState = Task::eTaskState::TWaiting;
+#if TASKHANDLER_EVENTS
+		StartPendingEvent();
+#endif
+		break;
+
+#if TASKHANDLER_COROUTINES
+	case Task::eTaskType::TCoroutine:
+		// A suspended coroutine is scheduled already or waits for another task
+		if (mSuspended)
+		{
+			break;
+		}
+		// The coroutine reached its end
+		mResumePoint = 0;
+		mTaskState = Task::eTaskState::TDone;
+		ReleaseFollowUps();
+		break;
+#endif
+
+	default:
+		// End this task
+		mTaskState = Task::eTaskState::TDone;
+		ReleaseFollowUps();
+		if (TaskHandler::GetInstance()->mAutoReap)
+		{
+			TaskHandler::GetInstance()->mReap[mIndex / TASKHANDLER_READY_BITS] |= 1U << (mIndex % TASKHANDLER_READY_BITS);
+		}
+		break;
 	}
-	mCallback = iCallback;
+
+	TASKHANDLER_UNLOCK();
 }
 
-Task::~Task()
+#ifdef TASKHANDLER_STATISTICS
+Task::sStatistics Task::GetStatistics()
 {
-	DEBUG_DESTROY("Task");
+	DEBUG_METHOD_CALL("Task::GetStatistics");
+
+	sStatistics lStatistics;
+
+	// Copy with locked interrupts, the dispatcher may update the values meanwhile
+	TASKHANDLER_LOCK();
+	lStatistics = mStatistics;
+	TASKHANDLER_UNLOCK();
+
+	return lStatistics;
 }
 
-Task *Task::GetNewTask(eTaskType iTaskType, int iTicks, void (*iCallback)(void))
+void Task::ResetStatistics()
 {
-	DEBUG_METHOD_CALL("Task::GetNewTask");
+	DEBUG_METHOD_CALL("Task::ResetStatistics");
 
-	Task *lTask;
+	TASKHANDLER_LOCK();
+	mStatistics.RunCount = 0;
+	mStatistics.MinExecutionUs = 0xFFFFFFFFUL;
+	mStatistics.MaxExecutionUs = 0;
+	mStatistics.TotalExecutionUs = 0;
+	mStatistics.MaxJitterUs = 0;
+	mStatistics.Overruns = 0;
+	TASKHANDLER_UNLOCK();
+}
+#endif
 
-	lTask = new Task(iTaskType, iTicks, iCallback);
+bool Task::IsBlocked()
+{
+	DEBUG_METHOD_CALL("Task::IsBlocked");
 
-	// add to task list
-	TaskHandler::GetInstance()->GetTaskList()->Add(lTask);
+	// All previous tasks must be done
+	return mPendingPrevious > 0;
+}
 
-	return lTask;
+void Task::ReleaseFollowUps()
+{
+	DEBUG_METHOD_CALL("Task::ReleaseFollowUps");
+
+	TASKHANDLER_LOCK();
+
+	// Each follow up task counts its pending previous tasks down, the last one starts counting of the ticks
+	for (sFollowUp *lLink = mFollowUps; lLink != nullptr; lLink = lLink->Next)
+	{
+		Task *lFollowUp = lLink->FollowUp;
+
+		if ((lFollowUp->mPendingPrevious > 0) && (--lFollowUp->mPendingPrevious == 0) && (lFollowUp->mTaskState == Task::eTaskState::TRunning))
+		{
+#if TASKHANDLER_COROUTINES
+			// An awaiting coroutine continues with the next tick
+			TaskHandler::GetInstance()->Schedule(lFollowUp, (lFollowUp->mTaskType == Task::eTaskType::TCoroutine) ? 1 : lFollowUp->mTicks);
+#else
+			TaskHandler::GetInstance()->Schedule(lFollowUp, lFollowUp->mTicks);
+#endif
+		}
+	}
+
+	TASKHANDLER_UNLOCK();
 }
 
-void Task::Process()
+void Task::DefinePrevious(Task *iPreviouslyProcessed)
 {
-	DEBUG_METHOD_CALL("Task::Process");
+	DEBUG_METHOD_CALL("Task::DefinePrevious");
 
-	// Process a single task
+	// Only follow up tasks wait for their previous tasks
+	WaitFor(iPreviouslyProcessed, (mTaskType == Task::eTaskType::TFollowUpCyclic) || (mTaskType == Task::eTaskType::TFollowUpOneTime));
+}
 
-	// Check if the task is done or waiting for a trigger
-	if ((mTaskState == Task::eTaskState::TDone) || (mTaskState == Task::eTaskState::TWaiting))
+bool Task::WaitFor(Task *iPrevious, bool iCount)
+{
+	DEBUG_METHOD_CALL("Task::WaitFor");
+
+	sFollowUp *lLink;
+	bool lBlocked = false;
+
+	if ((iPrevious == nullptr) || (iPrevious == this))
 	{
-		return;
+		return false;
+	}
+
+	// Each dependency is stored only once
+	for (lLink = iPrevious->mFollowUps; (lLink != nullptr) && (lLink->FollowUp != this); lLink = lLink->Next)
+		;
+
+	// A follow up task counts each previous task only once, a coroutine may await the same task again
+#if TASKHANDLER_COROUTINES
+	if ((lLink != nullptr) && (mTaskType != Task::eTaskType::TCoroutine))
+#else
+	if (lLink != nullptr)
+#endif
+	{
+		return false;
 	}
 
-	// Check dependency of tasks
-	if ((mTaskType == Task::eTaskType::TFollowUpCyclic) || (mTaskType == Task::eTaskType::TFollowUpOneTime))
+	if (lLink == nullptr)
 	{
-		// The previous task must be done
-		if (mPreviouslyProcessed != nullptr)
+		lLink = TaskHandler::GetInstance()->AllocateFollowUp();
+		if (lLink == nullptr)
 		{
-			if (mPreviouslyProcessed->mTaskState != Task::eTaskState::TDone)
-			{
-				return;
-			}
+			return false;
 		}
+		lLink->FollowUp = this;
+
+		TASKHANDLER_LOCK();
+		lLink->Next = iPrevious->mFollowUps;
+		iPrevious->mFollowUps = lLink;
+		TASKHANDLER_UNLOCK();
+	}
+
+	TASKHANDLER_LOCK();
+
+	// A blocked task is not counted down before the previous task is done
+	if (iCount && (iPrevious->mTaskState != Task::eTaskState::TDone))
+	{
+		mPendingPrevious++;
+		TaskHandler::GetInstance()->Unschedule(this);
+		lBlocked = true;
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	return lBlocked;
+}
+
+#if TASKHANDLER_COROUTINES
+uint16_t Task::GetResumePoint()
+{
+	return mResumePoint;
+}
+
+void Task::Suspend(uint16_t iResumePoint, int iTicks)
+{
+	DEBUG_METHOD_CALL("Task::Suspend");
+
+	mResumePoint = iResumePoint;
+	mSuspended = true;
+	TaskHandler::GetInstance()->Schedule(this, iTicks);
+}
+
+bool Task::Await(uint16_t iResumePoint, Task *iPrevious)
+{
+	DEBUG_METHOD_CALL("Task::Await");
+
+	mResumePoint = iResumePoint;
+	mSuspended = WaitFor(iPrevious, true);
+	return mSuspended;
+}
+#endif
+
+#if TASKHANDLER_DUAL_CORE
+void Task::SetCore(eCore iCore)
+{
+	DEBUG_METHOD_CALL("Task::SetCore");
+
+	mCore = iCore;
+}
+#endif
+
+void Task::SetMissedTickPolicy(eMissedTickPolicy iPolicy)
+{
+	DEBUG_METHOD_CALL("Task::SetMissedTickPolicy");
+
+	mMissedTickPolicy = iPolicy;
+}
+
+unsigned int Task::GetElapsedPeriods()
+{
+	return mElapsedPeriods;
+}
+
+unsigned long Task::GetMissedPeriods()
+{
+	return mMissedPeriods;
+}
+
+#if TASKHANDLER_EVENTS
+void Task::Subscribe(uint8_t iEventId, eEventPolicy iPolicy)
+{
+	DEBUG_METHOD_CALL("Task::Subscribe");
+
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	if ((iEventId != TASKHANDLER_NO_EVENT) && (iEventId >= TASKHANDLER_MAX_EVENTS))
+	{
+		return;
 	}
 
-	// Count down
-	mTaskCounter -= 1;
+	TASKHANDLER_LOCK();
 
-	if (mTaskCounter <= 0)
+	// Remove the previous subscription
+	if (mEventId != TASKHANDLER_NO_EVENT)
 	{
-		// Call registered task handler
-		// DEBUG_PRINT("Task: "+ this->
-		mCallback();
+		Task **lLink = &lHandler->mSubscribers[mEventId];
 
-		switch (mTaskType)
+		while (*lLink != this)
 		{
-		case Task::eTaskType::TCyclic:
-		case Task::eTaskType::TFollowUpCyclic:
-			// Restart a cyclic task
-			mTaskCounter = mTicks;
-			break;
+			lLink = &(*lLink)->mEventNext;
+		}
+		*lLink = mEventNext;
+		mEventNext = nullptr;
+	}
 
-		case Task::eTaskType::TTriggerOneTime:
-			// Set a startable task to waiting
-			mTaskState = Task::eTaskState::TWaiting;
-			break;
+	mEventId = iEventId;
+	mEventPolicy = iPolicy;
+	mPendingEvents = 0;
+	if (iEventId != TASKHANDLER_NO_EVENT)
+	{
+		mEventNext = lHandler->mSubscribers[iEventId];
+		lHandler->mSubscribers[iEventId] = this;
+	}
 
-		default:
-			// End this task
-			mTaskState = Task::eTaskState::TDone;
-			break;
+	TASKHANDLER_UNLOCK();
+}
+
+void Task::Trigger()
+{
+	// Pending events are counted or merged depending on the policy
+	if (mEventPolicy == Task::eEventPolicy::TCoalesce)
+	{
+		mPendingEvents = 1;
+	}
+	else if (mPendingEvents < 0xFFFF)
+	{
+		mPendingEvents++;
+	}
+	StartPendingEvent();
+}
+
+void Task::StartPendingEvent()
+{
+	// The dispatcher can trigger the task at the same time, if the task runs in the main loop
+	TASKHANDLER_LOCK();
+
+	if ((mPendingEvents > 0) && (mTaskState == Task::eTaskState::TWaiting))
+	{
+		mPendingEvents--;
+		Start();
+	}
+
+	TASKHANDLER_UNLOCK();
+}
+#endif
+
+bool Task::IsEnded()
+{
+	return (mTaskState == Task::eTaskState::TDone) || ((TaskHandler::GetInstance()->mReap[mIndex / TASKHANDLER_READY_BITS] & (1U << (mIndex % TASKHANDLER_READY_BITS))) != 0);
+}
+
+void Task::Cancel()
+{
+	DEBUG_METHOD_CALL("Task::Cancel");
+
+	TASKHANDLER_LOCK();
+
+	// The task is removed later, because the dispatcher or RunPending could be processing it right now
+	TaskHandler::GetInstance()->Unschedule(this);
+	if (mTaskState != Task::eTaskState::TDone)
+	{
+		// Follow up tasks do not wait for the cancelled task
+		mTaskState = Task::eTaskState::TDone;
+		ReleaseFollowUps();
+	}
+	TaskHandler::GetInstance()->mReap[mIndex / TASKHANDLER_READY_BITS] |= 1U << (mIndex % TASKHANDLER_READY_BITS);
+
+	TASKHANDLER_UNLOCK();
+}
+
+void Task::Pause()
+{
+	DEBUG_METHOD_CALL("Task::Pause");
+
+	TASKHANDLER_LOCK();
+
+	if ((mTaskState == Task::eTaskState::TWaiting) || (mTaskState == Task::eTaskState::TRunning))
+	{
+		mPausedState = mTaskState;
+		mTaskState = Task::eTaskState::TPaused;
+		TaskHandler::GetInstance()->Unschedule(this);
+	}
+
+	TASKHANDLER_UNLOCK();
+}
+
+void Task::Resume()
+{
+	DEBUG_METHOD_CALL("Task::Resume");
+
+	TASKHANDLER_LOCK();
+
+	if (mTaskState == Task::eTaskState::TPaused)
+	{
+		mTaskState = mPausedState;
+		if ((mTaskState == Task::eTaskState::TRunning) && !IsBlocked())
+		{
+			TaskHandler::GetInstance()->Schedule(this, mTicks);
 		}
+#if TASKHANDLER_EVENTS
+		// Events posted during the pause start a waiting task now
+		StartPendingEvent();
+#endif
+	}
+
+	TASKHANDLER_UNLOCK();
+
+	// The resumed task adds to the utilization again
+	if (TaskHandler::GetInstance()->IsUtilizing(this))
+	{
+		TaskHandler::GetInstance()->CheckSchedulability(this);
 	}
 }
 
-void Task::DefinePrevious(Task *iPreviouslyProcessed)
+void Task::SetTicks(int iTicks)
 {
-	DEBUG_METHOD_CALL("Task::DefinePrevious");
+	DEBUG_METHOD_CALL("Task::SetTicks");
+
+	// A cyclic task keeps its next due tick, the new period counts from there
+	mTicks = (iTicks > 0) ? iTicks : 1;
+	if (mWorstCaseUs > 0)
+	{
+		TaskHandler::GetInstance()->CheckSchedulability(this);
+	}
+}
+
+bool Task::SetWorstCaseExecution(unsigned long iMicros)
+{
+	DEBUG_METHOD_CALL("Task::SetWorstCaseExecution");
 
-	mPreviouslyProcessed = iPreviouslyProcessed;
+	mWorstCaseUs = iMicros;
+	return TaskHandler::GetInstance()->CheckSchedulability(this);
+}
+
+int Task::GetTicks()
+{
+	return mTicks;
 }
 
 void Task::Start()
@@ -332,7 +3044,10 @@ void Task::Start()
 	if (mTaskState == Task::eTaskState::TWaiting)
 	{
 		mTaskState = Task::eTaskState::TRunning;
-		mTaskCounter = mTicks;
+		if (!IsBlocked())
+		{
+			TaskHandler::GetInstance()->Schedule(this, mTicks);
+		}
 	}
 }
 
@@ -340,9 +3055,22 @@ void Task::Restart()
 {
 	DEBUG_METHOD_CALL("Task::Restart");
 
-	if ((mTaskState == Task::eTaskState::TWaiting) || (mTaskState == Task::eTaskState::TRunning))
+	if ((mTaskState == Task::eTaskState::TWaiting) || (mTaskState == Task::eTaskState::TRunning) || (mTaskState == Task::eTaskState::TPaused))
 	{
 		mTaskState = Task::eTaskState::TRunning;
-		mTaskCounter = mTicks;
+#if TASKHANDLER_COROUTINES
+		// A coroutine starts again from its beginning
+		mResumePoint = 0;
+#endif
+		if (!IsBlocked())
+		{
+			TaskHandler::GetInstance()->Schedule(this, mTicks);
+		}
+	}
+
+	// A paused task restarted adds to the utilization again
+	if (TaskHandler::GetInstance()->IsUtilizing(this))
+	{
+		TaskHandler::GetInstance()->CheckSchedulability(this);
 	}
 }
@@ -7,8 +7,52 @@
 #ifndef _TaskHandler_h
 #define _TaskHandler_h
 
-#include "List.h"
+// Without Arduino framework the task handler runs on the host with a simulated timer in virtual time
+#if not defined(ARDUINO) and not defined(TASKHANDLER_HOST)
+#define TASKHANDLER_HOST
+#endif
+
+// Optional features cost RAM in each task and in the task handler, so each one can be switched off with 0 or on with 1,
+// e.g. -D TASKHANDLER_EVENTS=0. On ARDUINO_AVR_UNO they are off by default. Statistics are switched on by -D TASKHANDLER_STATISTICS.
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_FEATURE_DEFAULT 0
+#else
+#define TASKHANDLER_FEATURE_DEFAULT 1
+#endif
+// Events posted by TaskHandler::Post start the subscribed tasks
+#ifndef TASKHANDLER_EVENTS
+#define TASKHANDLER_EVENTS TASKHANDLER_FEATURE_DEFAULT
+#endif
+// One-shot timers armed by TaskHandler::After
+#ifndef TASKHANDLER_ONE_SHOTS
+#define TASKHANDLER_ONE_SHOTS TASKHANDLER_FEATURE_DEFAULT
+#endif
+// Coroutine tasks created by Task::GetNewCoroutine
+#ifndef TASKHANDLER_COROUTINES
+#define TASKHANDLER_COROUTINES TASKHANDLER_FEATURE_DEFAULT
+#endif
+// The dispatcher shares the task handler with a second core - on the host the second core is simulated by a thread
+#ifndef TASKHANDLER_DUAL_CORE
+#if defined(TASKHANDLER_HOST) or defined(ARDUINO_NANO_RP2040_CONNECT)
+#define TASKHANDLER_DUAL_CORE 1
+#else
+#define TASKHANDLER_DUAL_CORE 0
+#endif
+#endif
+
+#ifdef TASKHANDLER_HOST
+#include <stdint.h>
+#else
+#include <Arduino.h>
+#endif
 #include "Debug.h"
+#include "List.h"
+
+// Commands for remote control are available only on the target with debugging switched off
+#if (DEBUG_APPLICATION == 0) and not defined(TASKHANDLER_HOST)
+#define TASKHANDLER_REMOTE_CONTROL
+#include "TextBase.h"
+#endif
 
 // #if DEBUG_APPLICATION > 0
 // #define TIMER_INTERRUPT_DEBUG 3
@@ -21,6 +65,131 @@
 // #define LOCAL_DEBUG 0
 // #endif
 
+// Size of the hierarchical timing wheel: each level has 2^TASKHANDLER_WHEEL_BITS slots.
+// The default covers 16^3 = 4096 ticks directly, tasks with longer delays are cascaded again.
+#ifndef TASKHANDLER_WHEEL_BITS
+#define TASKHANDLER_WHEEL_BITS 4
+#endif
+#ifndef TASKHANDLER_WHEEL_LEVELS
+#define TASKHANDLER_WHEEL_LEVELS 3
+#endif
+#define TASKHANDLER_WHEEL_SLOTS (1 << TASKHANDLER_WHEEL_BITS)
+#define TASKHANDLER_WHEEL_MASK (TASKHANDLER_WHEEL_SLOTS - 1)
+
+// Maximum number of tasks - each task owns one bit of the ready mask used by the deferred execution
+#ifndef TASKHANDLER_MAX_TASKS
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_MAX_TASKS 16
+#else
+#define TASKHANDLER_MAX_TASKS 64
+#endif
+#endif
+// With -D TASKHANDLER_STATIC_TASKS tasks and dependency edges are taken from static tables instead of the heap
+#ifndef TASKHANDLER_MAX_FOLLOW_UPS
+#define TASKHANDLER_MAX_FOLLOW_UPS TASKHANDLER_MAX_TASKS
+#endif
+#define TASKHANDLER_READY_BITS (sizeof(unsigned int) * 8)
+#define TASKHANDLER_READY_WORDS ((TASKHANDLER_MAX_TASKS + TASKHANDLER_READY_BITS - 1) / TASKHANDLER_READY_BITS)
+
+// Capacity of the queue of each core in dual core execution mode, a power of 2 up to 128.
+// A task is queued at most once, so the queues never overflow with at least TASKHANDLER_MAX_TASKS entries.
+#ifndef TASKHANDLER_CORE_QUEUE_SIZE
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_CORE_QUEUE_SIZE 16
+#else
+#define TASKHANDLER_CORE_QUEUE_SIZE 64
+#endif
+#endif
+
+// Returned by GetTicksToNextDeadline, if no task is scheduled
+#define TASKHANDLER_NO_DEADLINE 0xFFFFFFFFUL
+
+// Size of the preallocated pool of one-shot timers, see TaskHandler::After
+#ifndef TASKHANDLER_MAX_ONE_SHOTS
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_MAX_ONE_SHOTS 4
+#else
+#define TASKHANDLER_MAX_ONE_SHOTS 8
+#endif
+#endif
+// Returned by TaskHandler::After, if the pool is exhausted
+#define TASKHANDLER_NO_ONE_SHOT 0
+
+// Events: IDs from 0 to TASKHANDLER_MAX_EVENTS - 1 can be posted, the queue size must be a power of 2 up to 128
+#ifndef TASKHANDLER_MAX_EVENTS
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_MAX_EVENTS 8
+#else
+#define TASKHANDLER_MAX_EVENTS 16
+#endif
+#endif
+#ifndef TASKHANDLER_EVENT_QUEUE_SIZE
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_EVENT_QUEUE_SIZE 8
+#else
+#define TASKHANDLER_EVENT_QUEUE_SIZE 16
+#endif
+#endif
+#define TASKHANDLER_EVENT_QUEUE_MASK (TASKHANDLER_EVENT_QUEUE_SIZE - 1)
+#define TASKHANDLER_NO_EVENT 0xFF
+
+// Number of ticks checked for the load of a tick, when phases of cyclic tasks are staggered
+#ifndef TASKHANDLER_STAGGER_WINDOW
+#define TASKHANDLER_STAGGER_WINDOW 1024
+#endif
+// Maximum number of phases tried for a new cyclic task, when phases of cyclic tasks are staggered
+#ifndef TASKHANDLER_STAGGER_CANDIDATES
+#if defined(ARDUINO_AVR_UNO)
+#define TASKHANDLER_STAGGER_CANDIDATES 32
+#else
+#define TASKHANDLER_STAGGER_CANDIDATES 256
+#endif
+#endif
+
+// Runtime statistics of tasks and the dispatcher are compiled only with -D TASKHANDLER_STATISTICS.
+// Bucket i of the latency histogram counts interrupt latencies from 2^i to 2^(i+1)-1 microseconds, bucket 0 starts at 0.
+#ifndef TASKHANDLER_LATENCY_BUCKETS
+#define TASKHANDLER_LATENCY_BUCKETS 12
+#endif
+
+#if TASKHANDLER_COROUTINES
+// Statements for the body of a coroutine task, see Task::GetNewCoroutine.
+// Local variables of the coroutine are not kept across TASK_YIELD, TASK_SLEEP and TASK_AWAIT - store them in the context.
+// A switch statement must not enclose these statements.
+#define TASK_BEGIN(iTask) switch ((iTask)->GetResumePoint()) \
+    {                                                         \
+    case 0:
+#define TASK_SLEEP(iTask, iTicks)       \
+    (iTask)->Suspend(__LINE__, iTicks); \
+    return;                             \
+    __attribute__((fallthrough));       \
+    case __LINE__:
+#define TASK_YIELD(iTask) TASK_SLEEP(iTask, 1)
+#define TASK_AWAIT(iTask, iPrevious)              \
+    __attribute__((fallthrough));                 \
+    case __LINE__:                                \
+        if ((iTask)->Await(__LINE__, iPrevious)) \
+            return;
+#define TASK_END(iTask) }
+#endif
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+/// <summary>
+/// Local text class of the module
+/// </summary>
+class TextTaskHandler : public TextBase
+{
+public:
+    TextTaskHandler();
+    ~TextTaskHandler();
+
+    String GetObjectName() override;
+    String FunctionNameUnknown(char iModuleIdentifyer, char iParameter);
+    String TaskListDone();
+    String NoTaskSelected();
+};
+#endif
+
 void TaskDispatcher();
 
 /// <summary>
@@ -35,22 +204,202 @@ public:
         TCyclic = 'C',          // This task runs ever and ever again
         TFollowUpOneTime = 'o', // This task runs after ending a well defined other task once
         TFollowUpCyclic = 'c',  // This task runs after ending a well defined other task ever and ever again
-        TTriggerOneTime = 'T'   // Task runs a defined time after a trigger is recognized
+        TTriggerOneTime = 'T',  // Task runs a defined time after a trigger is recognized
+#if TASKHANDLER_COROUTINES
+        TCoroutine = 'Y'        // This task runs as coroutine, that can yield, sleep and await other tasks until its end
+#endif
+    };
+
+    // Reaction of cyclic tasks on periods, that passed while ticks were lost, e.g. with interrupts masked during an EEPROM write.
+    // The next period is always calculated from the absolute due tick, so the long-term rate is held with all policies.
+    enum class eMissedTickPolicy : char
+    {
+        TCatchUp = 'U', // Every missed period is executed, the task runs several times in a row
+        TSkip = 'S',    // Missed periods are dropped and counted, the task runs once and stays in phase
+        TCoalesce = 'M' // Missed periods are merged into one run, GetElapsedPeriods tells the callback how many periods it covers
+    };
+
+#if TASKHANDLER_DUAL_CORE
+    // Core calling the callback in dual core execution mode
+    enum class eCore : char
+    {
+        TCore0 = '0',  // The task runs on core 0 with the main loop and the timer interrupt, e.g. for I/O with low latency
+        TCore1 = '1',  // The task runs on the second core, e.g. for heavy processing
+        TAnyCore = 'A' // The task runs on the core with fewer queued tasks, the second core if both are equal
+    };
+#endif
+
+#if TASKHANDLER_EVENTS
+    // Reaction of a subscribed task on events, that arrive while it is running already
+    enum class eEventPolicy : char
+    {
+        TCoalesce = 'M', // All events until the task starts again are merged into one run
+        TCount = 'N'     // The task runs once for each event
+    };
+#endif
+
+#ifdef TASKHANDLER_STATISTICS
+    struct sStatistics
+    {
+        unsigned long RunCount;         // number of callback calls
+        unsigned long MinExecutionUs;   // shortest callback duration
+        unsigned long MaxExecutionUs;   // longest callback duration
+        unsigned long TotalExecutionUs; // sum of all callback durations - divided by RunCount it's the average
+        unsigned long MaxJitterUs;      // largest delay between the processed tick and the start of the callback
+        unsigned int Overruns;          // callback took longer than the period or was still pending when the task expired again
     };
 
+    /// <summary>
+    /// Gets the runtime statistics of the task
+    /// </summary>
+    /// <returns>Statistics since start or last reset</returns>
+    sStatistics GetStatistics();
+
+    /// <summary>
+    /// Sets all statistic values of the task back
+    /// </summary>
+    void ResetStatistics();
+#endif
+
+    /// <summary>
+    /// Creates a new task and registers it at the task handler
+    /// </summary>
+    /// <param name="iTaskType">Kind of task</param>
+    /// <param name="iTicks">Number of ticks relevant for that task</param>
+    /// <param name="iCallback">Address of the function implementing the task handler</param>
+    /// <returns>New task or nullptr, if TASKHANDLER_MAX_TASKS is reached</returns>
     static Task *GetNewTask(eTaskType iTaskType, int iTicks, void (*iCallback)(void));
 
     /// <summary>
-    /// Central task loop triggered by a cyclic timer event
+    /// Creates a new task with a callback, that gets a context - one function can serve several instances of a module
+    /// </summary>
+    /// <param name="iTaskType">Kind of task</param>
+    /// <param name="iTicks">Number of ticks relevant for that task</param>
+    /// <param name="iCallback">Address of the function implementing the task handler</param>
+    /// <param name="iContext">Pointer handed over to the callback, e.g. the instance of a module</param>
+    /// <returns>New task or nullptr, if TASKHANDLER_MAX_TASKS is reached</returns>
+    static Task *GetNewTask(eTaskType iTaskType, int iTicks, void (*iCallback)(void *), void *iContext);
+
+#if TASKHANDLER_COROUTINES
+    /// <summary>
+    /// Creates a new coroutine task. The coroutine is enclosed by TASK_BEGIN and TASK_END and continues
+    /// after TASK_YIELD, TASK_SLEEP or TASK_AWAIT with the next run of the task. It is done, when it reaches TASK_END.
+    /// </summary>
+    /// <param name="iTicks">Number of ticks until the coroutine is called 1st</param>
+    /// <param name="iCoroutine">Address of the function implementing the coroutine, it gets the task and the context</param>
+    /// <param name="iContext">Pointer handed over to the coroutine</param>
+    /// <returns>New task or nullptr, if TASKHANDLER_MAX_TASKS is reached</returns>
+    static Task *GetNewCoroutine(int iTicks, void (*iCoroutine)(Task *, void *), void *iContext);
+
+    /// <summary>
+    /// Gets the position, where a coroutine continues - used by TASK_BEGIN
+    /// </summary>
+    /// <returns>Line of the last TASK_YIELD, TASK_SLEEP or TASK_AWAIT, 0 at the beginning</returns>
+    uint16_t GetResumePoint();
+
+    /// <summary>
+    /// Suspends a coroutine for a number of ticks - used by TASK_SLEEP and TASK_YIELD
+    /// </summary>
+    /// <param name="iResumePoint">Position, where the coroutine continues</param>
+    /// <param name="iTicks">Number of ticks to sleep</param>
+    void Suspend(uint16_t iResumePoint, int iTicks);
+
+    /// <summary>
+    /// Suspends a coroutine until the given task is done - used by TASK_AWAIT
+    /// </summary>
+    /// <param name="iResumePoint">Position, where the coroutine continues</param>
+    /// <param name="iPrevious">Task to wait for</param>
+    /// <returns>true: the coroutine must return and waits, false: the given task is done already</returns>
+    bool Await(uint16_t iResumePoint, Task *iPrevious);
+#endif
+
+    /// <summary>
+    /// Processes the task when its deadline is reached - called by the task handler only for expired tasks.
+    /// In deferred execution mode, the task is only marked as ready.
     /// </summary>
     void Process();
 
     /// <summary>
-    /// The given task must be done before this task can start
+    /// The given task must be done before this task can start.
+    /// Can be called several times: a follow up task starts after all of its previous tasks are done,
+    /// and a task can be the previous task of several follow up tasks.
     /// </summary>
     /// <param name="iPreviouslyProcessed">Given task</param>
     void DefinePrevious(Task *iPreviouslyProcessed);
 
+    /// <summary>
+    /// Selects the reaction of a cyclic task on missed periods - default is TCatchUp
+    /// </summary>
+    /// <param name="iPolicy">Policy for missed periods</param>
+    void SetMissedTickPolicy(eMissedTickPolicy iPolicy);
+
+#if TASKHANDLER_DUAL_CORE
+    /// <summary>
+    /// Pins the task to a core for the dual core execution mode - default is TAnyCore.
+    /// Without a started second core all tasks run on core 0.
+    /// </summary>
+    /// <param name="iCore">Core calling the callback</param>
+    void SetCore(eCore iCore);
+#endif
+
+    /// <summary>
+    /// Gets the number of periods covered by the current run - can be called by the callback
+    /// </summary>
+    /// <returns>1 normally, more if missed periods were coalesced into this run</returns>
+    unsigned int GetElapsedPeriods();
+
+    /// <summary>
+    /// Gets the number of periods dropped by TSkip since start
+    /// </summary>
+    /// <returns>Number of dropped periods</returns>
+    unsigned long GetMissedPeriods();
+
+#if TASKHANDLER_EVENTS
+    /// <summary>
+    /// Starts the task each time the event is posted by TaskHandler::Post, usually used with TTriggerOneTime.
+    /// A task subscribes to one event, a new subscription replaces the previous one.
+    /// </summary>
+    /// <param name="iEventId">Event from 0 to TASKHANDLER_MAX_EVENTS - 1, TASKHANDLER_NO_EVENT removes the subscription</param>
+    /// <param name="iPolicy">Handling of events arriving while the task is running</param>
+    void Subscribe(uint8_t iEventId, eEventPolicy iPolicy);
+#endif
+
+    /// <summary>
+    /// Ends the task and removes it from the task handler. Its follow up tasks do not wait for it any more.
+    /// The task is recycled by the main loop with the next RunPending or GetNewTask - after that the pointer must not be used any more.
+    /// </summary>
+    void Cancel();
+
+    /// <summary>
+    /// Stops a waiting or running task until Resume is called - the task keeps its settings
+    /// </summary>
+    void Pause();
+
+    /// <summary>
+    /// Continues a paused task in the state it had before, a running task starts counting its ticks again
+    /// </summary>
+    void Resume();
+
+    /// <summary>
+    /// Changes the number of ticks of the task - a scheduled task uses it from its next run on
+    /// </summary>
+    /// <param name="iTicks">Number of ticks relevant for that task</param>
+    void SetTicks(int iTicks);
+
+    /// <summary>
+    /// Declares the worst case execution time of the callback. The task handler checks the utilization of all cyclic tasks
+    /// against the rate monotonic bound and logs an overload by ERROR_PRINT.
+    /// </summary>
+    /// <param name="iMicros">Longest duration of the callback in microseconds, 0 if unknown</param>
+    /// <returns>false: the cyclic tasks need more than the whole CPU - with admission control the task is paused</returns>
+    bool SetWorstCaseExecution(unsigned long iMicros);
+
+    /// <summary>
+    /// Gets the number of ticks of the task
+    /// </summary>
+    /// <returns>Number of ticks relevant for that task</returns>
+    int GetTicks();
+
     /// <summary>
     /// Starts a task, if it's not running already
     /// </summary>
@@ -66,25 +415,142 @@ private:
     {
         TWaiting = 'W', // the current task is waiting for being processed
         TRunning = 'R', // the current task is currently running
-        TDone = 'D'     // the current task has ended
+        TDone = 'D',    // the current task has ended
+        TPaused = 'P'   // the current task is stopped until it's resumed
     };
 
-    volatile eTaskState mTaskState; // current state of the task
-    volatile eTaskType mTaskType;   // type of the current task
-    volatile int mTaskCounter;      // internal counter for ticks (starts with _mTicks and then counts down to 0)
-    volatile int mTicks;            // number of internal timer cycles
+    volatile eTaskState mTaskState;     // current state of the task
+    eTaskState mPausedState;            // state of the task before it was paused
+    volatile eTaskType mTaskType;       // type of the current task
+    volatile unsigned long mDueTick;    // absolute tick of the task handler, when the task expires next
+    volatile int mTicks;                // number of internal timer cycles
+    uint8_t mIndex;                     // position in the task table of the task handler and bit in its ready mask
 
     /// <summary>
-    /// Constructor
+    /// Constructor - tasks are initialized when they are used, so removed tasks can be reused
+    /// </summary>
+    Task();
+    ~Task();
+
+    /// <summary>
+    /// Sets all members to the state of a new task
     /// </summary>
     /// <param name="iTaskType">Kind of task</param>
-    /// <param name="iTicks">Number of ticks relevant for that task - depending on iTaskType, it can control the cycle time or time until a task starts</param>
+    /// <param name="iTicks">Number of ticks relevant for that task</param>
     /// <param name="iCallback">Address of the function implementing the task handler</param>
-    Task(eTaskType iTaskType, int iTicks, void (*iCallback)());
-    ~Task();
+    void Initialize(eTaskType iTaskType, int iTicks, void (*iCallback)());
+
+    /// <summary>
+    /// Gets memory for a new task - a removed task, the heap or the static task table
+    /// </summary>
+    /// <param name="iTaskType">Kind of task</param>
+    /// <param name="iTicks">Number of ticks relevant for that task</param>
+    /// <param name="iCallback">Address of the function implementing the task handler</param>
+    /// <returns>Initialized task or nullptr, if there is no memory</returns>
+    static Task *Create(eTaskType iTaskType, int iTicks, void (*iCallback)());
+
+    /// <summary>
+    /// Registers a new task at the task handler and schedules it, if it is running
+    /// </summary>
+    /// <param name="iTask">New task</param>
+    /// <returns>The task or nullptr, if TASKHANDLER_MAX_TASKS is reached</returns>
+    static Task *Activate(Task *iTask);
+
+    /// <summary>
+    /// Calls the callback and finishes the current run of the task
+    /// </summary>
+    void Execute();
 
-    volatile Task *mPreviouslyProcessed = nullptr; // Previous task
-    void (*mCallback)();                           // Address of the function implementing the task handler
+    /// <summary>
+    /// Checks, if the task has ended or is to be removed, so it must not run again
+    /// </summary>
+    /// <returns>true: the task is done or cancelled</returns>
+    bool IsEnded();
+
+    /// <summary>
+    /// Checks, if a follow up task has to wait for its previous task
+    /// </summary>
+    /// <returns>true: the previous task is not done yet</returns>
+    bool IsBlocked();
+
+    /// <summary>
+    /// Counts down the pending previous tasks of all follow up tasks and schedules the ones without pending previous tasks - called after this task is done
+    /// </summary>
+    void ReleaseFollowUps();
+
+    /// <summary>
+    /// Adds this task to the tasks waiting for a previous task
+    /// </summary>
+    /// <param name="iPrevious">Previous task</param>
+    /// <param name="iCount">true: this task is blocked until the previous task is done</param>
+    /// <returns>true: this task is blocked now</returns>
+    bool WaitFor(Task *iPrevious, bool iCount);
+
+    /// <summary>
+    /// Edge of the dependency graph: one task waiting for this task
+    /// </summary>
+    struct sFollowUp
+    {
+        Task *FollowUp;  // task that waits
+        sFollowUp *Next; // next edge of the same previous task
+    };
+
+    /// <summary>
+    /// Address of the function implementing the task handler - the kind depends on mHasContext and mTaskType
+    /// </summary>
+    union uCallback
+    {
+        void (*Plain)();
+        void (*WithContext)(void *);
+#if TASKHANDLER_COROUTINES
+        void (*Coroutine)(Task *, void *);
+#endif
+    };
+
+    uCallback mCallback;          // Address of the function implementing the task handler
+    void *mContext = nullptr;     // Context handed over to the callback
+    bool mHasContext = false;     // true: the callback gets the context
+#if TASKHANDLER_COROUTINES
+    bool mSuspended = false;      // true: the coroutine did not reach its end during the current run
+    uint16_t mResumePoint = 0;    // position, where the coroutine continues
+#endif
+
+    eMissedTickPolicy mMissedTickPolicy = eMissedTickPolicy::TCatchUp; // reaction on missed periods
+    unsigned int mElapsedPeriods = 1;                                   // periods covered by the current run
+    unsigned long mMissedPeriods = 0;                                   // periods dropped by TSkip
+    unsigned long mWorstCaseUs = 0;                                     // declared worst case execution time of the callback
+#if TASKHANDLER_DUAL_CORE
+    eCore mCore = eCore::TAnyCore;                                      // core calling the callback in dual core execution mode
+#endif
+
+#if TASKHANDLER_EVENTS
+    uint8_t mEventId = TASKHANDLER_NO_EVENT;                // event, the task is subscribed to
+    eEventPolicy mEventPolicy = eEventPolicy::TCoalesce;    // handling of events arriving while the task is running
+    volatile uint16_t mPendingEvents = 0;                   // events, that still have to start the task
+    Task *mEventNext = nullptr;                             // next task subscribed to the same event
+
+    /// <summary>
+    /// Starts the task for a posted event or keeps the event pending, while the task is running
+    /// </summary>
+    void Trigger();
+
+    /// <summary>
+    /// Starts the task again for a pending event - called after a run
+    /// </summary>
+    void StartPendingEvent();
+#endif
+
+    Task *mWheelNext = nullptr;              // next task in the same slot of the timing wheel
+    Task **mWheelPrevious = nullptr;         // link that points to this task - nullptr, if the task is not scheduled
+    sFollowUp *mFollowUps = nullptr;         // tasks that wait for this task
+    volatile uint8_t mPendingPrevious = 0;   // number of previous tasks, that are not done yet
+
+#ifdef TASKHANDLER_STATISTICS
+    sStatistics mStatistics;     // runtime statistics
+    unsigned long mReleaseMicros; // time, when the tick of the current run was processed
+#endif
+
+    friend class TaskHandler;
 };
 
 /// <summary>
@@ -93,6 +559,15 @@ private:
 class TaskHandler
 {
 public:
+    enum class eExecutionMode : char
+    {
+        TImmediate = 'I', // Callbacks are called directly from the timer interrupt
+        TDeferred = 'D',  // The timer interrupt marks tasks as ready, RunPending calls the callbacks from the main loop
+        TParallel = 'P',  // Host only: the timer interrupt hands ready tasks over to the worker threads, see SetWorkerThreads
+        TDualCore = 'C'   // RP2040 and host: the timer interrupt queues ready tasks for their core, RunPending of each core calls the callbacks.
+                          // Without TASKHANDLER_DUAL_CORE it works like the deferred execution mode
+    };
+
     /// <summary>
     /// Factory for managing single instances
     /// </summary>
@@ -102,17 +577,503 @@ public:
     /// <summary>
     /// Initialize hardware timer depending on hardware
     /// </summary>
-    /// <param name="iCycleTimeInMs">Set Cycle time of the timer in milliseconds</param>
-    void SetCycleTimeInMs(unsigned long iCycleTimeInMs);
+    /// <param name="iCycleTimeInMs">Set Cycle time of the timer in milliseconds - that is the length of one tick</param>
+    /// <param name="iTickless">false: the timer fires every tick, true: the timer fires only at the next deadline of a task.
+    /// Tickless mode needs a free running hardware counter, on other processors the timer keeps firing every tick.
+    /// On ARDUINO_AVR_UNO, ARDUINO_AVR_NANO_EVERY and ARDUINO_ARDUINO_NANO33BLE the timer is not programmed yet:
+    /// it keeps its preset period and each interrupt counts as one tick, whatever the cycle time is.</param>
+    void SetCycleTimeInMs(unsigned long iCycleTimeInMs, bool iTickless = false);
+
+    /// <summary>
+    /// Processes all ticks elapsed since the last call and programs the next timer event in tickless mode - called by the timer interrupt
+    /// </summary>
+    void Dispatch();
+
+    /// <summary>
+    /// Calculates the distance to the next time, the task handler has work to do
+    /// </summary>
+    /// <returns>Number of ticks or TASKHANDLER_NO_DEADLINE, if no task is scheduled</returns>
+    unsigned long GetTicksToNextDeadline();
 
     /// <summary>
-    /// Get a list of all tasks
+    /// Puts the processor into idle sleep until the next interrupt, e.g. the next deadline or serial input.
+    /// Returns immediately, if tasks are pending for RunPending. Can be called at the end of the main loop.
+    /// </summary>
+    void Idle();
+
+    /// <summary>
+    /// Gets the time of the task handler
+    /// </summary>
+    /// <returns>Number of ticks processed since start</returns>
+    unsigned long GetTickCount();
+
+#if TASKHANDLER_ONE_SHOTS
+    /// <summary>
+    /// Arms a one-shot timer from the preallocated pool - can be called from interrupts, no task and no heap is used.
+    /// The callback is called from interrupt context, so it should be short, e.g. start a task.
+    /// With a free running counter (tickless mode of SAMD TC3, host) the resolution is below one tick,
+    /// otherwise the timer expires with the first tick after the given time.
+    /// </summary>
+    /// <param name="iMicros">Time from now in microseconds</param>
+    /// <param name="iCallback">Function called once, when the time has passed</param>
+    /// <param name="iContext">Pointer handed over to the callback</param>
+    /// <returns>Handle of the timer or TASKHANDLER_NO_ONE_SHOT, if TASKHANDLER_MAX_ONE_SHOTS timers are armed</returns>
+    uint16_t After(unsigned long iMicros, void (*iCallback)(void *), void *iContext);
+
+    /// <summary>
+    /// Disarms a one-shot timer - can be called from interrupts
+    /// </summary>
+    /// <param name="iHandle">Handle returned by After</param>
+    /// <returns>true: the timer was disarmed, false: it expired already or the handle is invalid</returns>
+    bool Cancel(uint16_t iHandle);
+
+    /// <summary>
+    /// Calls the callbacks of all expired one-shot timers and programs the compare channel to the next one - called by the timer interrupts
+    /// </summary>
+    void DispatchOneShots();
+#endif
+
+#if TASKHANDLER_EVENTS
+    /// <summary>
+    /// Posts an event - can be called from interrupts and from the main loop.
+    /// The events are dispatched in a batch to the subscribed tasks with the next tick.
+    /// </summary>
+    /// <param name="iEventId">Event from 0 to TASKHANDLER_MAX_EVENTS - 1</param>
+    /// <returns>false: the event queue is full or the event is invalid</returns>
+    bool Post(uint8_t iEventId);
+#endif
+
+#ifdef TASKHANDLER_HOST
+    /// <summary>
+    /// Advances the simulated hardware timer in virtual time - the dispatcher is called whenever the simulated timer fires.
+    /// Ticks without timer event are skipped, so the simulation runs as fast as the host allows.
+    /// </summary>
+    /// <param name="iTicks">Number of ticks to simulate</param>
+    void SimulateTicks(unsigned long iTicks);
+
+    /// <summary>
+    /// Advances the simulated hardware timer without calling the dispatcher, like a timer interrupt lost while interrupts are masked.
+    /// The next dispatcher call processes the lost ticks.
+    /// </summary>
+    /// <param name="iTicks">Number of lost ticks</param>
+    void SimulateLostTicks(unsigned long iTicks);
+
+    /// <summary>
+    /// Starts a pool of worker threads for the parallel execution mode - the running workers are stopped before.
+    /// Each worker takes tasks from its own queue and steals tasks from the other queues, when its own queue is empty.
+    /// Without workers the parallel execution mode works like the deferred execution mode.
+    /// </summary>
+    /// <param name="iThreads">Number of workers, 0 stops all workers</param>
+    void SetWorkerThreads(unsigned int iThreads);
+
+    /// <summary>
+    /// Waits until the workers and the simulated second core have processed all tasks handed over to them
+    /// </summary>
+    void WaitForWorkers();
+
+#if TASKHANDLER_DUAL_CORE
+    /// <summary>
+    /// Stops the simulated second core after it has emptied its queue
+    /// </summary>
+    void StopSecondCore();
+#endif
+
+    /// <summary>
+    /// Gets the number of simulated timer interrupts, e.g. for measuring the throughput of the dispatcher
+    /// </summary>
+    /// <returns>Number of dispatcher calls since start</returns>
+    unsigned long GetDispatchCount();
+
+    /// <summary>
+    /// Gets the number of called task callbacks
+    /// </summary>
+    /// <returns>Number of callbacks since start</returns>
+    unsigned long GetRunCount();
+#endif
+
+    /// <summary>
+    /// Selects, if one-time tasks are removed and recycled automatically after their run like cancelled tasks.
+    /// Pointers to these tasks must not be used after their run, e.g. for DefinePrevious or TASK_AWAIT.
+    /// The tasks are recycled by the main loop with RunPending or GetNewTask, never by the timer interrupt.
+    /// </summary>
+    /// <param name="iAutoReap">true: done TOneTime and TFollowUpOneTime tasks are recycled</param>
+    void SetAutoReap(bool iAutoReap);
+
+    /// <summary>
+    /// Selects, where the callbacks of expired tasks are called
+    /// </summary>
+    /// <param name="iExecutionMode">TImmediate: in the timer interrupt, TDeferred: in RunPending</param>
+    void SetExecutionMode(eExecutionMode iExecutionMode);
+
+    /// <summary>
+    /// Selects, if new cyclic tasks get a phase offset, so tasks with the same or harmonic periods do not expire at the same tick
+    /// </summary>
+    /// <param name="iStaggering">true: the first run of a new cyclic task is placed on the ticks with the lowest load</param>
+    void SetPhaseStaggering(bool iStaggering);
+
+    /// <summary>
+    /// Assigns the phases of all running cyclic tasks again, the most expensive tasks first.
+    /// With -D TASKHANDLER_STATISTICS the measured average callback duration weights the tasks.
+    /// </summary>
+    void Restagger();
+
+    /// <summary>
+    /// Calculates the highest load of a single tick, until the pattern of the cyclic tasks repeats, at most within the next TASKHANDLER_STAGGER_WINDOW ticks
+    /// </summary>
+    /// <returns>Number of callbacks, or sum of the average callback durations in microseconds with -D TASKHANDLER_STATISTICS</returns>
+    unsigned long GetWorstCaseLoad();
+
+    /// <summary>
+    /// Calculates the projected CPU utilization of all waiting and running cyclic tasks with a declared worst case execution time
+    /// </summary>
+    /// <returns>Utilization in per mille of the CPU</returns>
+    unsigned long GetUtilization();
+
+    /// <summary>
+    /// Selects, if a task is rejected, when its worst case execution time overloads the CPU
+    /// </summary>
+    /// <param name="iAdmissionControl">true: the task is paused, false: the overload is logged only</param>
+    void SetAdmissionControl(bool iAdmissionControl);
+
+    /// <summary>
+    /// Calls the callbacks of all tasks marked as ready - must be called from main loop in deferred execution mode.
+    /// In dual core execution mode only the tasks queued for the calling core are called.
+    /// </summary>
+    void RunPending();
+
+#if TASKHANDLER_DUAL_CORE
+    /// <summary>
+    /// Starts the second core, that calls RunPending whenever tasks are queued for it in dual core execution mode.
+    /// On the host a thread simulates the second core.
+    /// </summary>
+    void StartSecondCore();
+#endif
+
+    /// <summary>
+    /// Gets the number of registered tasks
+    /// </summary>
+    /// <returns>Number of tasks</returns>
+    uint8_t GetTaskCount();
+
+    /// <summary>
+    /// Gets a registered task
+    /// </summary>
+    /// <param name="iIndex">Index of the task</param>
+    /// <returns>Task or nullptr, if the index is out of range</returns>
+    Task *GetTask(uint8_t iIndex);
+
+    /// <summary>
+    /// Get a list of all tasks - kept for existing code, new code uses GetTaskCount and GetTask without heap.
+    /// The list is filled again at each call and does not own the tasks, so it must not be changed.
     /// </summary>
     /// <returns>Instance of object collection</returns>
     ListCollection *GetTaskList();
 
+#ifdef TASKHANDLER_STATISTICS
+    /// <summary>
+    /// Gets the histogram of the interrupt latency of the dispatcher
+    /// </summary>
+    /// <returns>Array with TASKHANDLER_LATENCY_BUCKETS counters</returns>
+    const uint16_t *GetLatencyHistogram();
+
+    /// <summary>
+    /// Sets the statistics of the dispatcher and all tasks back
+    /// </summary>
+    void ResetStatistics();
+#endif
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+    /// <summary>
+    /// Dispatches commands got from en external input, e.g. a serial interface
+    /// </summary>
+    /// <param name="iModuleIdentifyer">If this matches with the identifyer of this module, then iParameter is analyzed:
+    /// 'T' : Command for task handler operations</param>
+    /// <param name="iParameter">Parameter or command that is to be analyzed:
+    /// '0' : Resets the task iterator
+    /// 'I' : Returns type, state, ticks and counters of the next task and selects it
+    /// 'P' : Pauses the selected task
+    /// 'G' : Resumes the selected task
+    /// 'X' : Restarts the selected task
+    /// '+' / '-' : Doubles / halves the ticks of the selected task
+    /// '>' / '<' : Increases / decreases the ticks of the selected task by 1
+    /// 'L' : Returns the worst case load of a tick
+    /// 'U' : Returns the projected CPU utilization in per mille
+    /// 'S' : Staggers the phases of all cyclic tasks again
+    /// 'R' : Returns the statistics of the next task
+    /// 'H' : Returns the latency histogram of the dispatcher
+    /// 'C' : Clears all statistics
+    /// </param>
+    /// <returns>Reaction of dispatching</returns>
+    String DispatchSerial(char iModuleIdentifyer, char iParameter);
+#endif
+
 private:
-    ListCollection *mTaskList; // List object containing the tasks
+    Task *mTasks[TASKHANDLER_MAX_TASKS] = {};                                 // Table of all tasks
+    uint8_t mTaskCount = 0;                                                   // Number of registered tasks
+    Task *mWheel[TASKHANDLER_WHEEL_LEVELS][TASKHANDLER_WHEEL_SLOTS] = {};     // Hierarchical timing wheel: each slot chains the tasks expiring there
+    ListCollection *mTaskList = nullptr;                                      // Copy of the task table for GetTaskList, created at the 1st call
+    Task *mExpiring = nullptr;                                                // Slot detached by the current tick - its tasks can still be unscheduled by callbacks
+    volatile unsigned long mTickCount = 0;                                    // Number of ticks since start of the task handler
+    unsigned long mDispatchTarget = 0;                                        // Tick, that is reached at the end of the current dispatcher call
+    volatile unsigned int mReady[TASKHANDLER_READY_WORDS] = {};               // One bit per task, set by the timer interrupt in deferred execution mode
+    volatile unsigned int mReap[TASKHANDLER_READY_WORDS] = {};                // One bit per task, that is to be removed
+    bool mAutoReap = false;                                                   // true: done one-time tasks are removed
+    Task *mFreeTasks = nullptr;                                               // Removed tasks for reuse, chained by their wheel link
+    Task::sFollowUp *mFreeFollowUps = nullptr;                                // Released dependency edges for reuse
+    eExecutionMode mExecutionMode = eExecutionMode::TImmediate;              // Where callbacks are called
+    bool mTickless = false;                                                   // true: the timer is programmed to the next deadline only
+    bool mDispatching = false;                                                // true: the timer interrupt is processing ticks
+    bool mPhaseStaggering = false;                                            // true: new cyclic tasks get a phase offset
+    bool mAdmissionControl = false;                                           // true: tasks overloading the CPU are paused
+#if TASKHANDLER_DUAL_CORE
+    volatile bool mSecondCore = false;                                        // true: the second core takes the tasks queued for it
+#endif
+    volatile unsigned long mProgrammedTick = 0;                               // Tick, at which the timer fires next in tickless mode
+    unsigned long mCycleTimeInUs = 1000;                                      // Length of one tick
+
+#if TASKHANDLER_ONE_SHOTS
+    /// <summary>
+    /// Entry of the pool of one-shot timers
+    /// </summary>
+    struct sOneShot
+    {
+        unsigned long DueMicros;   // time, when the timer expires
+        void (*Callback)(void *);  // function called, when the timer expires
+        void *Context;             // pointer handed over to the callback
+        uint8_t Generation;        // counts the uses of the entry, so outdated handles are detected
+        bool Armed;                // true: the timer waits for its time
+    };
+    sOneShot mOneShots[TASKHANDLER_MAX_ONE_SHOTS] = {};                      // Pool of one-shot timers
+#endif
+#if TASKHANDLER_EVENTS
+    Task *mSubscribers[TASKHANDLER_MAX_EVENTS] = {};                          // Tasks subscribed to each event
+    volatile uint8_t mEvents[TASKHANDLER_EVENT_QUEUE_SIZE] = {};              // Queue of posted events
+    volatile uint8_t mEventHead = 0;                                          // Number of posted events, changed by Post
+    volatile uint8_t mEventTail = 0;                                          // Number of dispatched events, changed by the dispatcher only
+#endif
+
+#ifdef TASKHANDLER_HOST
+    unsigned long mDispatchCount = 0;                                         // Number of simulated timer interrupts
+    unsigned long mRunCount = 0;                                              // Number of called task callbacks
+#endif
+
+#ifdef TASKHANDLER_HOST
+    /// <summary>
+    /// Main function of a worker thread
+    /// </summary>
+    /// <param name="iWorker">Index of the worker</param>
+    static void Worker(unsigned int iWorker);
+
+    /// <summary>
+    /// Calls the callback of a task on a worker thread and releases the task for the next hand over
+    /// </summary>
+    /// <param name="iTask">Task taken from a queue</param>
+    void ExecuteParallel(Task *iTask);
+#endif
+
+#ifdef TASKHANDLER_STATISTICS
+    uint16_t mLatencyHistogram[TASKHANDLER_LATENCY_BUCKETS] = {};             // Interrupt latency of the dispatcher
+    unsigned long mLastDispatchMicros = 0;                                    // Entry time of the last dispatcher call
+    unsigned long mExpectedTicks = 1;                                         // Number of ticks until the next expected dispatcher call
+    unsigned long mTickMicros = 0;                                            // Time, when the current tick was processed
+#endif
+
+#ifdef TASKHANDLER_STATIC_TASKS
+    Task mTaskPool[TASKHANDLER_MAX_TASKS];                                    // Static memory of the tasks
+    Task::sFollowUp mFollowUpPool[TASKHANDLER_MAX_FOLLOW_UPS];                // Static memory of the dependency edges
+    uint8_t mTaskPoolCount = 0;                                               // Number of used entries of the static task table
+    uint8_t mFollowUpCount = 0;                                               // Number of used dependency edges
+#endif
+
+    /// <summary>
+    /// Removes all elements of the list returned by GetTaskList without deleting the tasks
+    /// </summary>
+    void DetachTaskList();
+
+    /// <summary>
+    /// Takes a removed task or new memory - from the heap or from the static task table
+    /// </summary>
+    /// <returns>Task or nullptr, if there is no memory</returns>
+    Task *AllocateTask();
+
+    /// <summary>
+    /// Puts a task, that is not registered, into the list of removed tasks
+    /// </summary>
+    /// <param name="iTask">Task for reuse</param>
+    void FreeTask(Task *iTask);
+
+    /// <summary>
+    /// Takes a released dependency edge or new memory
+    /// </summary>
+    /// <returns>Edge or nullptr, if TASKHANDLER_MAX_FOLLOW_UPS is reached</returns>
+    Task::sFollowUp *AllocateFollowUp();
+
+    /// <summary>
+    /// Puts a dependency edge into the list of released edges
+    /// </summary>
+    /// <param name="iFollowUp">Edge for reuse</param>
+    void FreeFollowUp(Task::sFollowUp *iFollowUp);
+
+    /// <summary>
+    /// Removes all tasks marked for removal, that are not marked as ready - called from the main loop only,
+    /// because GetTask, GetTaskCount and the serial commands read the task table without locking
+    /// </summary>
+    void Reap();
+
+    /// <summary>
+    /// Removes a task from the task table in O(1) - the last task takes its index - and from all dependencies and events
+    /// </summary>
+    /// <param name="iIndex">Index of the task</param>
+    void Remove(uint8_t iIndex);
+
+#ifdef TASKHANDLER_REMOTE_CONTROL
+    TextTaskHandler mText;                                                    // Text objekt of the class
+    uint8_t mDispatchIterator = 0;                                            // Next task reported by remote control
+    uint8_t mSelectedTask = TASKHANDLER_MAX_TASKS;                            // Task changed by remote control, TASKHANDLER_MAX_TASKS if none is selected
+
+    // Commands for remote control
+    enum class eFunctionCode : char
+    {
+        TName = 'T',        // Code for this class, if controlled remotely
+        TReadReset = '0',   // Reset the task iterator
+        TReadNext = 'R',    // Read statistics of the next task and increase the iterator
+        TInfoNext = 'I',    // Read the settings of the next task, select it and increase the iterator
+        TPause = 'P',       // Pause the selected task
+        TResume = 'G',      // Resume the selected task
+        TRestart = 'X',     // Restart the selected task
+        TDouble = '+',      // Double the ticks of the selected task
+        THalve = '-',       // Halve the ticks of the selected task
+        TIncrease = '>',    // Increase the ticks of the selected task
+        TDecrease = '<',    // Decrease the ticks of the selected task
+        THistogram = 'H',   // Read the latency histogram
+        TClear = 'C',       // Clear all statistics
+        TLoad = 'L',        // Read the worst case load of a tick
+        TUtilization = 'U', // Read the projected CPU utilization
+        TStagger = 'S'      // Stagger the phases of cyclic tasks again
+    };
+#endif
+
+    /// <summary>
+    /// Advances the time of the task handler by one tick and processes only the tasks that expire at this tick
+    /// </summary>
+    void Tick();
+
+    /// <summary>
+    /// Programs the timer to the next deadline in tickless mode
+    /// </summary>
+    void Reprogram();
+
+    /// <summary>
+    /// Checks the utilization of the cyclic tasks after a task changed and logs an overload
+    /// </summary>
+    /// <param name="iTask">Changed task</param>
+    /// <returns>false: the CPU is overloaded</returns>
+    bool CheckSchedulability(Task *iTask);
+
+    /// <summary>
+    /// Checks, if a task is part of the CPU utilization: a running or waiting cyclic task with worst case execution time
+    /// </summary>
+    /// <param name="iTask">Task</param>
+    /// <returns>true: the task is summed up by GetUtilization</returns>
+    bool IsUtilizing(Task *iTask);
+
+    /// <summary>
+    /// Schedules the first run of a cyclic task at the phase, that meets the scheduled tasks with the lowest weight.
+    /// Only the phases up to the least common multiple of the common divisors with the other periods are tried, at most TASKHANDLER_STAGGER_CANDIDATES.
+    /// The search runs on a snapshot of the scheduled tasks with unlocked interrupts.
+    /// </summary>
+    /// <param name="iTask">Cyclic task, that is not scheduled</param>
+    void Stagger(Task *iTask);
+
+    /// <summary>
+    /// Sums up the weights of all scheduled tasks, that expire at a tick
+    /// </summary>
+    /// <param name="iTick">Absolute tick</param>
+    /// <returns>Load of the tick</returns>
+    unsigned long GetLoad(unsigned long iTick);
+
+    /// <summary>
+    /// Gets the cost of a single run of a task
+    /// </summary>
+    /// <param name="iTask">Task</param>
+    /// <returns>1, or the average callback duration in microseconds with -D TASKHANDLER_STATISTICS</returns>
+    unsigned long GetWeight(Task *iTask);
+
+    /// <summary>
+    /// Calculates the number of ticks, after which the pattern of all scheduled cyclic tasks repeats
+    /// </summary>
+    /// <param name="iPeriod">Period of an additional task</param>
+    /// <returns>Least common multiple of the periods, at most TASKHANDLER_STAGGER_WINDOW</returns>
+    unsigned long GetStaggerWindow(unsigned long iPeriod);
+
+#if TASKHANDLER_EVENTS
+    /// <summary>
+    /// Hands all events posted until now over to the subscribed tasks - called by the dispatcher
+    /// </summary>
+    void DispatchEvents();
+#endif
+
+#if TASKHANDLER_ONE_SHOTS
+    /// <summary>
+    /// Programs the compare channel of the free running counter to the earliest armed one-shot timer
+    /// </summary>
+    void ProgramOneShots();
+#endif
+
+    /// <summary>
+    /// Adds a task to the task table
+    /// </summary>
+    /// <param name="iTask">Task to add</param>
+    /// <returns>true, if there was space for the task</returns>
+    bool Register(Task *iTask);
+
+    /// <summary>
+    /// Marks a task as ready for RunPending - called by the timer interrupt
+    /// </summary>
+    /// <param name="iIndex">Index of the task</param>
+    void MarkReady(uint8_t iIndex);
+
+#if TASKHANDLER_DUAL_CORE
+    /// <summary>
+    /// Queues a task marked as ready for its core - called by the timer interrupt in dual core execution mode
+    /// </summary>
+    /// <param name="iTask">Expired task</param>
+    void SubmitToCore(Task *iTask);
+
+    /// <summary>
+    /// Calls the callback of a task taken from the queue of a core and releases the task for the next hand over
+    /// </summary>
+    /// <param name="iTask">Task taken from a queue</param>
+    void ExecuteOnCore(Task *iTask);
+#endif
+
+    /// <summary>
+    /// Inserts a task into the timing wheel
+    /// </summary>
+    /// <param name="iTask">Task to schedule</param>
+    /// <param name="iTicks">Number of ticks from now, when the task expires - at least 1</param>
+    void Schedule(Task *iTask, int iTicks);
+
+    /// <summary>
+    /// Removes a task from the timing wheel, if it is scheduled
+    /// </summary>
+    /// <param name="iTask">Task to remove</param>
+    void Unschedule(Task *iTask);
+
+    /// <summary>
+    /// Links a task into the matching slot of the wheel based on its due tick
+    /// </summary>
+    /// <param name="iTask">Task to link</param>
+    void Link(Task *iTask);
+
+    /// <summary>
+    /// Moves all tasks of one slot of a higher level into the lower levels
+    /// </summary>
+    /// <param name="iLevel">Level of the wheel</param>
+    /// <param name="iSlot">Slot of that level</param>
+    void Cascade(int iLevel, int iSlot);
+
+    friend class Task;
 
     /// <summary>
     /// Constructor
@@ -0,0 +1,132 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Benchmarks of SmallVector against ListCollection on the host, run by: pio test -e native -v
+// The times are printed only - they depend on the host and are not checked.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "List.h"
+#include "SmallVector.h"
+
+#define BENCHMARK_ELEMENTS 64
+#define BENCHMARK_ROUNDS 20000
+
+static uint32_t gValues[BENCHMARK_ELEMENTS];
+
+/// <summary>
+/// Prints the time per round of a benchmark
+/// </summary>
+/// <param name="iName">Name of the benchmark</param>
+/// <param name="iStart">Start of the measurement</param>
+static void Report(const char *iName, std::chrono::steady_clock::time_point iStart)
+{
+	char lText[80];
+	double lNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - iStart).count() / BENCHMARK_ROUNDS;
+
+	snprintf(lText, sizeof(lText), "%s: %.1f ns per round", iName, lNanos);
+	TEST_MESSAGE(lText);
+}
+
+void setUp(void)
+{
+	for (uint32_t lIndex = 0; lIndex < BENCHMARK_ELEMENTS; lIndex++)
+	{
+		gValues[lIndex] = lIndex;
+	}
+}
+
+void tearDown(void)
+{
+}
+
+void test_iterate()
+{
+	SmallVector<uint32_t *, BENCHMARK_ELEMENTS> lVector;
+	ListCollection lList;
+	volatile uint32_t lSum = 0;
+	uint32_t lVectorSum = 0;
+	uint32_t lListSum = 0;
+	std::chrono::steady_clock::time_point lStart;
+
+	// The list owns its objects, so it gets copies
+	for (uint32_t lIndex = 0; lIndex < BENCHMARK_ELEMENTS; lIndex++)
+	{
+		lVector.Add(&gValues[lIndex]);
+		lList.Add(new uint32_t(gValues[lIndex]));
+	}
+
+	lStart = std::chrono::steady_clock::now();
+	for (long lRound = 0; lRound < BENCHMARK_ROUNDS; lRound++)
+	{
+		for (uint32_t *lValue : lVector)
+		{
+			lSum = lSum + *lValue;
+		}
+	}
+	Report("SmallVector iterate", lStart);
+	lVectorSum = lSum;
+
+	lSum = 0;
+	lStart = std::chrono::steady_clock::now();
+	for (long lRound = 0; lRound < BENCHMARK_ROUNDS; lRound++)
+	{
+		ListElement *lIterator = lList.IterateStart();
+		void *lValue;
+
+		while ((lValue = lList.Iterate(&lIterator)) != nullptr)
+		{
+			lSum = lSum + *(uint32_t *)lValue;
+		}
+	}
+	Report("ListCollection iterate", lStart);
+	lListSum = lSum;
+
+	TEST_ASSERT_EQUAL_UINT32(lVectorSum, lListSum);
+}
+
+void test_insert_delete()
+{
+	SmallVector<uint32_t *, BENCHMARK_ELEMENTS> lVector;
+	ListCollection lList;
+	std::chrono::steady_clock::time_point lStart;
+
+	lStart = std::chrono::steady_clock::now();
+	for (long lRound = 0; lRound < BENCHMARK_ROUNDS; lRound++)
+	{
+		for (uint32_t lIndex = 0; lIndex < BENCHMARK_ELEMENTS; lIndex++)
+		{
+			lVector.Add(&gValues[lIndex]);
+		}
+		while (!lVector.IsEmpty())
+		{
+			lVector.RemoveSwap(0);
+		}
+	}
+	Report("SmallVector insert and delete", lStart);
+	TEST_ASSERT_EQUAL(0, lVector.Count());
+
+	lStart = std::chrono::steady_clock::now();
+	for (long lRound = 0; lRound < BENCHMARK_ROUNDS; lRound++)
+	{
+		for (uint32_t lIndex = 0; lIndex < BENCHMARK_ELEMENTS; lIndex++)
+		{
+			lList.Add(new uint32_t(gValues[lIndex]));
+		}
+		while (lList.Count() > 0)
+		{
+			lList.Delete(0);
+		}
+	}
+	Report("ListCollection insert and delete", lStart);
+	TEST_ASSERT_EQUAL(0, lList.Count());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_iterate);
+	RUN_TEST(test_insert_delete);
+	return UNITY_END();
+}
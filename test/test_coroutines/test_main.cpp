@@ -0,0 +1,102 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Tests of coroutine tasks in virtual time on the host, run by: pio test -e native
+
+#include <unity.h>
+#include "TaskHandler.h"
+
+// State of a coroutine, that must survive between its runs
+struct sSteps
+{
+	int Step;	   // last step reached
+	int Loop;	   // counter of the sleeping loop
+	Task *Awaited; // task awaited in the last step
+};
+
+static int gAwaitedRuns = 0;
+
+static void Awaited()
+{
+	gAwaitedRuns++;
+}
+
+static void Steps(Task *iTask, void *iContext)
+{
+	sSteps *lSteps = (sSteps *)iContext;
+
+	TASK_BEGIN(iTask);
+	lSteps->Step = 1;
+	TASK_YIELD(iTask);
+	lSteps->Step = 2;
+	for (lSteps->Loop = 0; lSteps->Loop < 3; lSteps->Loop++)
+	{
+		TASK_SLEEP(iTask, 10);
+	}
+	lSteps->Step = 3;
+	TASK_AWAIT(iTask, lSteps->Awaited);
+	lSteps->Step = 4;
+	TASK_END(iTask);
+}
+
+void setUp(void)
+{
+	TaskHandler::GetInstance()->SetCycleTimeInMs(1);
+	gAwaitedRuns = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_yield_sleep_await()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	sSteps lSteps = {0, 0, nullptr};
+
+	lSteps.Awaited = Task::GetNewTask(Task::eTaskType::TOneTime, 100, Awaited);
+	Task::GetNewCoroutine(5, Steps, &lSteps);
+
+	// The coroutine starts after 5 ticks and yields for one tick
+	lHandler->SimulateTicks(5);
+	TEST_ASSERT_EQUAL(1, lSteps.Step);
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(2, lSteps.Step);
+
+	// Three sleeps of 10 ticks each
+	lHandler->SimulateTicks(29);
+	TEST_ASSERT_EQUAL(2, lSteps.Step);
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(3, lSteps.Step);
+
+	// The awaited task runs at tick 100, the coroutine continues at the tick after
+	lHandler->SimulateTicks(63);
+	TEST_ASSERT_EQUAL(3, lSteps.Step);
+	TEST_ASSERT_EQUAL(0, gAwaitedRuns);
+	lHandler->SimulateTicks(2);
+	TEST_ASSERT_EQUAL(1, gAwaitedRuns);
+	TEST_ASSERT_EQUAL(4, lSteps.Step);
+}
+
+void test_await_done_task()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	sSteps lSteps = {0, 0, nullptr};
+
+	lSteps.Awaited = Task::GetNewTask(Task::eTaskType::TOneTime, 1, Awaited);
+	lHandler->SimulateTicks(2);
+	TEST_ASSERT_EQUAL(1, gAwaitedRuns);
+
+	// A task, that is done already, does not block the coroutine
+	Task::GetNewCoroutine(1, Steps, &lSteps);
+	lHandler->SimulateTicks(1 + 1 + 30 + 1);
+	TEST_ASSERT_EQUAL(4, lSteps.Step);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_yield_sleep_await);
+	RUN_TEST(test_await_done_task);
+	return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Tests of events, one-shot timers and mailboxes in virtual time on the host, run by: pio test -e native
+
+#include <unity.h>
+#include "Mailbox.h"
+
+#define TEST_EVENT 3
+#define TEST_MAILBOX_EVENT 2
+
+// Message passed through the mailbox
+struct sMessage
+{
+	int Value; // payload
+};
+
+static Mailbox<sMessage, 8> gMailbox(TEST_MAILBOX_EVENT);
+static int gRuns[2];
+static int gReceived = 0;
+static int gSum = 0;
+static long gFired[TASKHANDLER_MAX_ONE_SHOTS + 2];
+static int gFiredCount = 0;
+
+static void Count(void *iContext)
+{
+	gRuns[(long)iContext]++;
+}
+
+static void Fire(void *iContext)
+{
+	gFired[gFiredCount++] = (long)iContext;
+}
+
+static void Consume()
+{
+	sMessage lMessage;
+
+	gRuns[0]++;
+	while (gMailbox.Receive(&lMessage))
+	{
+		gReceived++;
+		gSum += lMessage.Value;
+	}
+}
+
+static void Produce()
+{
+	static int sValue = 0;
+
+	gMailbox.Post({sValue++});
+}
+
+void setUp(void)
+{
+	TaskHandler::GetInstance()->SetCycleTimeInMs(1);
+	gRuns[0] = gRuns[1] = 0;
+	gFiredCount = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_counted_and_coalesced_events()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	Task *lCoalesced = Task::GetNewTask(Task::eTaskType::TTriggerOneTime, 0, Count, (void *)0);
+	Task *lCounted = Task::GetNewTask(Task::eTaskType::TTriggerOneTime, 0, Count, (void *)1);
+
+	lCoalesced->Subscribe(TEST_EVENT, Task::eEventPolicy::TCoalesce);
+	lCounted->Subscribe(TEST_EVENT, Task::eEventPolicy::TCount);
+	lHandler->SimulateTicks(10);
+	TEST_ASSERT_EQUAL(0, gRuns[0] + gRuns[1]);
+
+	for (int lIndex = 0; lIndex < 5; lIndex++)
+	{
+		TEST_ASSERT_TRUE(lHandler->Post(TEST_EVENT));
+	}
+	TEST_ASSERT_FALSE(lHandler->Post(TASKHANDLER_MAX_EVENTS));
+
+	// Both start with the next tick, the counted task runs once more for each further event
+	lHandler->SimulateTicks(2);
+	TEST_ASSERT_EQUAL(1, gRuns[0]);
+	TEST_ASSERT_EQUAL(1, gRuns[1]);
+	lHandler->SimulateTicks(10);
+	TEST_ASSERT_EQUAL(1, gRuns[0]);
+	TEST_ASSERT_EQUAL(5, gRuns[1]);
+
+	// The queue is full after TASKHANDLER_EVENT_QUEUE_SIZE events
+	for (int lIndex = 0; lIndex < TASKHANDLER_EVENT_QUEUE_SIZE; lIndex++)
+	{
+		TEST_ASSERT_TRUE(lHandler->Post(TEST_EVENT));
+	}
+	TEST_ASSERT_FALSE(lHandler->Post(TEST_EVENT));
+	lHandler->SimulateTicks(100);
+	TEST_ASSERT_EQUAL(2, gRuns[0]);
+	TEST_ASSERT_EQUAL(5 + TASKHANDLER_EVENT_QUEUE_SIZE, gRuns[1]);
+
+	lCoalesced->Cancel();
+	lCounted->Cancel();
+	lHandler->RunPending();
+}
+
+void test_one_shots()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	uint16_t lLate;
+	uint16_t lEarly;
+	uint16_t lCancelled;
+	int lArmed = 0;
+
+	lLate = lHandler->After(2500, Fire, (void *)1);
+	lEarly = lHandler->After(700, Fire, (void *)2);
+	lCancelled = lHandler->After(5000, Fire, (void *)3);
+	TEST_ASSERT_TRUE((lLate != TASKHANDLER_NO_ONE_SHOT) && (lEarly != TASKHANDLER_NO_ONE_SHOT) && (lCancelled != TASKHANDLER_NO_ONE_SHOT));
+	TEST_ASSERT_TRUE(lHandler->Cancel(lCancelled));
+	TEST_ASSERT_FALSE(lHandler->Cancel(lCancelled));
+
+	// 700us expire within the 1st tick of 1ms
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(1, gFiredCount);
+	TEST_ASSERT_EQUAL(2, gFired[0]);
+	TEST_ASSERT_FALSE(lHandler->Cancel(lEarly));
+
+	lHandler->SimulateTicks(10);
+	TEST_ASSERT_EQUAL(2, gFiredCount);
+	TEST_ASSERT_EQUAL(1, gFired[1]);
+
+	// The pool has TASKHANDLER_MAX_ONE_SHOTS timers
+	while (lHandler->After(100000, Fire, (void *)9) != TASKHANDLER_NO_ONE_SHOT)
+	{
+		lArmed++;
+	}
+	TEST_ASSERT_EQUAL(TASKHANDLER_MAX_ONE_SHOTS, lArmed);
+	lHandler->SimulateTicks(200);
+	TEST_ASSERT_EQUAL(2 + TASKHANDLER_MAX_ONE_SHOTS, gFiredCount);
+}
+
+void test_mailbox_wakes_consumer()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	Task *lConsumer = Task::GetNewTask(Task::eTaskType::TTriggerOneTime, 0, Consume);
+	Task *lProducer;
+
+	gMailbox.Wake(lConsumer);
+	lHandler->SimulateTicks(50);
+	TEST_ASSERT_EQUAL(0, gRuns[0]);
+
+	// Each message wakes the consumer once
+	lProducer = Task::GetNewTask(Task::eTaskType::TCyclic, 10, Produce);
+	lHandler->SimulateTicks(101);
+	TEST_ASSERT_EQUAL(10, gRuns[0]);
+	TEST_ASSERT_EQUAL(10, gReceived);
+	TEST_ASSERT_EQUAL(45, gSum);
+
+	lProducer->Cancel();
+	for (int lIndex = 0; lIndex < 8; lIndex++)
+	{
+		TEST_ASSERT_TRUE(gMailbox.Post({1}));
+	}
+	TEST_ASSERT_FALSE(gMailbox.Post({1}));
+	TEST_ASSERT_EQUAL(8, gMailbox.Count());
+	lHandler->SimulateTicks(2);
+	TEST_ASSERT_TRUE(gMailbox.IsEmpty());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_counted_and_coalesced_events);
+	RUN_TEST(test_one_shots);
+	RUN_TEST(test_mailbox_wakes_consumer);
+	return UNITY_END();
+}
@@ -0,0 +1,239 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Tests of the list classes on the host, run by: pio test -e native
+
+#include <unity.h>
+#include <atomic>
+#include <stdlib.h>
+#include <thread>
+#include "List.h"
+
+#define LIST_TEST_MARK 0x5A5A5A5AUL
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_delete_twice_while_reading()
+{
+	ListCollection *lList = new ListCollection();
+	ListElement *lFirst;
+	ListElement *lSecond;
+
+	lList->Add(new uint32_t(LIST_TEST_MARK));
+	lList->Add(new uint32_t(LIST_TEST_MARK));
+	lList->Add(new uint32_t(LIST_TEST_MARK));
+	lFirst = lList->IterateStart();
+	lSecond = lFirst->mNext;
+
+	// Deleted elements are retired for the reader, a 2nd Delete must not find them in the list any more
+	lList->BeginRead();
+	TEST_ASSERT_TRUE(lList->Delete(lFirst));
+	TEST_ASSERT_TRUE(lList->Delete(lSecond));
+	TEST_ASSERT_FALSE(lList->Delete(lSecond));
+	TEST_ASSERT_FALSE(lList->Delete(lFirst));
+	TEST_ASSERT_EQUAL(1, lList->Count());
+	lList->EndRead();
+
+	// The retired elements are freed exactly once
+	delete lList;
+}
+
+void test_reader_thread_while_writer_changes_list()
+{
+	ListCollection lList;
+	std::atomic<bool> lStop(false);
+	std::atomic<bool> lCorrupt(false);
+	unsigned long lWalks = 0;
+
+	for (int lIndex = 0; lIndex < 50; lIndex++)
+	{
+		lList.Add(new uint32_t(LIST_TEST_MARK));
+	}
+
+	// The reader walks the list like an interrupt or the 2nd core, every object it reaches must still be valid
+	std::thread lReader([&]()
+						{
+		while (!lStop)
+		{
+			ListElement *lIterator;
+			void *lObject;
+
+			lList.BeginRead();
+			lIterator = lList.IterateStart();
+			while ((lObject = lList.Iterate(&lIterator)) != nullptr)
+			{
+				if (*(uint32_t *)lObject != LIST_TEST_MARK)
+				{
+					lCorrupt = true;
+				}
+			}
+			lList.EndRead();
+			lWalks++;
+		} });
+
+	srand(1);
+	for (long lStep = 0; lStep < 200000; lStep++)
+	{
+		if ((lList.Count() > 0) && ((lStep & 0xFF) == 0))
+		{
+			// Deleting a retired element a 2nd time must fail
+			ListElement *lElement = lList.IterateStart();
+
+			lList.BeginRead();
+			TEST_ASSERT_TRUE(lList.Delete(lElement));
+			TEST_ASSERT_FALSE(lList.Delete(lElement));
+			lList.EndRead();
+		}
+		else if ((lList.Count() > 0) && ((rand() & 1) != 0))
+		{
+			lList.Delete(rand() % lList.Count());
+		}
+		else
+		{
+			lList.Add(new uint32_t(LIST_TEST_MARK));
+		}
+		if ((lStep % 1000) == 0)
+		{
+			lList.Reclaim();
+		}
+	}
+
+	lStop = true;
+	lReader.join();
+	lList.Reclaim();
+
+	TEST_ASSERT_FALSE(lCorrupt);
+	TEST_ASSERT_GREATER_THAN(0, lWalks);
+}
+
+struct sByPriority
+{
+};
+
+// Object, that is part of two lists at the same time
+class TestItem : public ListHook<TestItem>, public ListHook<TestItem, sByPriority>
+{
+public:
+	int Value = 0;
+};
+
+void test_typed_list_with_two_hooks()
+{
+	List<TestItem> lOrder;
+	List<TestItem, sByPriority> lPriority;
+	TestItem lItems[4];
+	int lSum = 0;
+
+	for (int lIndex = 0; lIndex < 4; lIndex++)
+	{
+		lItems[lIndex].Value = lIndex;
+		TEST_ASSERT_TRUE(lOrder.Add(&lItems[lIndex]));
+		TEST_ASSERT_TRUE(lPriority.Add(&lItems[3 - lIndex]));
+	}
+	TEST_ASSERT_FALSE(lOrder.Add(&lItems[2]));
+
+	// Removing from one list leaves the other one unchanged
+	TEST_ASSERT_TRUE(lOrder.Remove(&lItems[1]));
+	TEST_ASSERT_FALSE(lOrder.Remove(&lItems[1]));
+	TEST_ASSERT_FALSE(lOrder.Contains(&lItems[1]));
+	TEST_ASSERT_TRUE(lPriority.Contains(&lItems[1]));
+	TEST_ASSERT_EQUAL(3, lOrder.Count());
+	TEST_ASSERT_EQUAL(4, lPriority.Count());
+	TEST_ASSERT_EQUAL(2, lOrder.Get(1)->Value);
+	TEST_ASSERT_EQUAL(1, lPriority.Get(2)->Value);
+
+	// The current object can be removed within the loop
+	for (TestItem *lItem : lOrder)
+	{
+		lSum += lItem->Value;
+		lOrder.Remove(lItem);
+	}
+	TEST_ASSERT_EQUAL(5, lSum);
+	TEST_ASSERT_TRUE(lOrder.IsEmpty());
+	TEST_ASSERT_EQUAL(3, lPriority.GetFirst()->Value);
+	TEST_ASSERT_EQUAL(0, lPriority.GetLast()->Value);
+}
+
+static uint32_t GetTestKey(void *iObject)
+{
+	return *(uint32_t *)iObject;
+}
+
+void test_find_by_key()
+{
+	ListCollection lList;
+	ListElement *lTable[8];
+
+	for (uint32_t lKey = 0; lKey < 100; lKey++)
+	{
+		lList.Add(new uint32_t(lKey));
+	}
+	TEST_ASSERT_FALSE(lList.SetKey(GetTestKey, lTable, 6));
+	TEST_ASSERT_TRUE(lList.SetKey(GetTestKey));
+	TEST_ASSERT_EQUAL(42, *(uint32_t *)lList.Find(42));
+
+	// Entries after a deleted one stay reachable
+	lList.Delete(42);
+	TEST_ASSERT_NULL(lList.Find(42));
+	for (uint32_t lKey = 0; lKey < 100; lKey++)
+	{
+		if (lKey != 42)
+		{
+			TEST_ASSERT_EQUAL(lKey, *(uint32_t *)lList.Find(lKey));
+		}
+	}
+	lList.Add(new uint32_t(100));
+	TEST_ASSERT_EQUAL(100, *(uint32_t *)lList.Find(100));
+
+	// Objects, that do not fit into a fixed table, are searched one by one
+	TEST_ASSERT_TRUE(lList.SetKey(GetTestKey, lTable, 8));
+	TEST_ASSERT_EQUAL(0, *(uint32_t *)lList.Find(0));
+	TEST_ASSERT_EQUAL(99, *(uint32_t *)lList.Find(99));
+	TEST_ASSERT_NULL(lList.Find(1000));
+}
+
+void test_handle_of_deleted_element()
+{
+	ListCollection lList;
+	ListHandle lFirst;
+	ListHandle lSecond;
+	ListHandle lReused;
+	ListHandle lInvalid;
+
+	TEST_ASSERT_TRUE(lList.Add(new uint32_t(1), &lFirst));
+	TEST_ASSERT_TRUE(lList.Add(new uint32_t(2), &lSecond));
+	TEST_ASSERT_EQUAL(2, *(uint32_t *)lList.Get(lSecond));
+	TEST_ASSERT_NULL(lList.Get(lInvalid));
+
+	TEST_ASSERT_TRUE(lList.Delete(lFirst));
+	TEST_ASSERT_FALSE(lList.Delete(lFirst));
+	TEST_ASSERT_NULL(lList.Get(lFirst));
+
+	// The slot is reused with a new generation, the old handle stays invalid
+	TEST_ASSERT_TRUE(lList.Add(new uint32_t(3), &lReused));
+	TEST_ASSERT_EQUAL(lFirst.Slot, lReused.Slot);
+	TEST_ASSERT_NULL(lList.Get(lFirst));
+	TEST_ASSERT_EQUAL(3, *(uint32_t *)lList.Get(lReused));
+
+	// Deleting by index invalidates the handle as well
+	TEST_ASSERT_TRUE(lList.Delete(0));
+	TEST_ASSERT_NULL(lList.Get(lSecond));
+	TEST_ASSERT_EQUAL(1, lList.Count());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_delete_twice_while_reading);
+	RUN_TEST(test_reader_thread_while_writer_changes_list);
+	RUN_TEST(test_typed_list_with_two_hooks);
+	RUN_TEST(test_find_by_key);
+	RUN_TEST(test_handle_of_deleted_element);
+	return UNITY_END();
+}
@@ -0,0 +1,440 @@
+// Arduino Base Libs
+// 18.10.2026
+// Stefan Rau
+// Tests of the task handler in virtual time on the host, run by: pio test -e native
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "TaskHandler.h"
+
+static Task *gTaskA = nullptr;
+static Task *gTaskB = nullptr;
+static Task *gTaskC = nullptr;
+static int gCountA = 0;
+static int gCountB = 0;
+static int gCountC = 0;
+
+void setUp(void)
+{
+	gCountA = 0;
+	gCountB = 0;
+	gCountC = 0;
+}
+
+void tearDown(void)
+{
+	Task *lTasks[] = {gTaskA, gTaskB, gTaskC};
+
+	TaskHandler::GetInstance()->SetAutoReap(true);
+	for (Task *lTask : lTasks)
+	{
+		if (lTask != nullptr)
+		{
+			lTask->Cancel();
+		}
+	}
+	TaskHandler::GetInstance()->RunPending();
+	gTaskA = gTaskB = gTaskC = nullptr;
+}
+
+static void CountB()
+{
+	gCountB++;
+}
+
+static void CountC()
+{
+	gCountC++;
+}
+
+// Pauses and restarts B once, while B and C wait behind A in the same slot of the timing wheel
+static void RestartB()
+{
+	if (gCountA++ == 0)
+	{
+		gTaskB->Pause();
+		gTaskB->Restart();
+	}
+}
+
+void test_restart_of_task_due_in_same_tick()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	// The last created task is the first in its slot, so A runs before B and C
+	gTaskC = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountC);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountB);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, RestartB);
+
+	lHandler->SimulateTicks(200);
+
+	TEST_ASSERT_EQUAL(20, gCountA);
+	// B is skipped once by the restart
+	TEST_ASSERT_EQUAL(19, gCountB);
+	TEST_ASSERT_EQUAL(20, gCountC);
+}
+
+static void CancelB()
+{
+	if (gCountA++ == 0)
+	{
+		gTaskB->Cancel();
+	}
+}
+
+void test_cancel_of_task_due_in_same_tick()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	gTaskC = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountC);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountB);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CancelB);
+
+	lHandler->SimulateTicks(200);
+
+	TEST_ASSERT_EQUAL(20, gCountA);
+	TEST_ASSERT_EQUAL(0, gCountB);
+	TEST_ASSERT_EQUAL(20, gCountC);
+}
+
+void test_cancel_after_marked_as_ready()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TDeferred);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 5, CountB);
+
+	// The timer interrupt marks A as ready, the main loop cancels it before RunPending
+	lHandler->SimulateTicks(5);
+	gTaskA->Cancel();
+	lHandler->RunPending();
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TImmediate);
+	// RunPending has recycled A
+	gTaskA = nullptr;
+
+	TEST_ASSERT_EQUAL(0, gCountB);
+}
+
+static void CancelItself()
+{
+	gCountA++;
+	gTaskA->Cancel();
+}
+
+void test_self_cancel_releases_follow_up_once()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TOneTime, 2, CancelItself);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TOneTime, 10, CountB);
+	gTaskC = Task::GetNewTask(Task::eTaskType::TFollowUpOneTime, 1, CountC);
+	gTaskC->DefinePrevious(gTaskA);
+	gTaskC->DefinePrevious(gTaskB);
+
+	// C waits for B, even though A cancelled itself while it was running
+	lHandler->SimulateTicks(5);
+	TEST_ASSERT_EQUAL(1, gCountA);
+	TEST_ASSERT_EQUAL(0, gCountB);
+	TEST_ASSERT_EQUAL(0, gCountC);
+
+	lHandler->SimulateTicks(10);
+	TEST_ASSERT_EQUAL(1, gCountB);
+	TEST_ASSERT_EQUAL(1, gCountC);
+}
+
+static std::atomic<int> gRunning(0);
+static std::atomic<int> gMaxRunning(0);
+static std::atomic<int> gRuns(0);
+
+// Runs longer than the main loop needs to call RunPending
+static void SlowParallel()
+{
+	int lRunning = ++gRunning;
+
+	if (lRunning > gMaxRunning)
+	{
+		gMaxRunning = lRunning;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	gRuns++;
+	gRunning--;
+}
+
+void test_parallel_task_runs_on_worker_only()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	gRunning = 0;
+	gMaxRunning = 0;
+	gRuns = 0;
+	lHandler->SetCycleTimeInMs(1);
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TParallel);
+	lHandler->SetWorkerThreads(2);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, SlowParallel);
+
+	for (int lPeriod = 0; lPeriod < 10; lPeriod++)
+	{
+		// The main loop runs, while a worker is calling A
+		lHandler->SimulateTicks(10);
+		lHandler->RunPending();
+		lHandler->WaitForWorkers();
+	}
+	lHandler->SetWorkerThreads(0);
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TImmediate);
+
+	TEST_ASSERT_EQUAL(10, gRuns.load());
+	TEST_ASSERT_EQUAL(1, gMaxRunning.load());
+}
+
+void test_admission_control_on_resume_and_restart()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	lHandler->SetAdmissionControl(true);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountC);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountB);
+	TEST_ASSERT_TRUE(gTaskA->SetWorstCaseExecution(6000));
+
+	// 600 + 500 per mille overload the CPU, so B is paused
+	TEST_ASSERT_FALSE(gTaskB->SetWorstCaseExecution(5000));
+	gTaskA->Pause();
+	gTaskB->Resume();
+
+	// A does not fit anymore, neither resumed nor restarted
+	gTaskA->Resume();
+	lHandler->SimulateTicks(50);
+	gTaskA->Restart();
+	lHandler->SimulateTicks(50);
+	lHandler->SetAdmissionControl(false);
+
+	TEST_ASSERT_EQUAL(0, gCountC);
+	TEST_ASSERT_EQUAL(10, gCountB);
+}
+
+static void CountA()
+{
+	gCountA++;
+}
+
+// Counts the periods, that each run of C covers
+static void CountCoalescedC()
+{
+	gCountC += gTaskC->GetElapsedPeriods();
+}
+
+void test_missed_tick_policies()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountA);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountB);
+	gTaskC = Task::GetNewTask(Task::eTaskType::TCyclic, 10, CountCoalescedC);
+	gTaskB->SetMissedTickPolicy(Task::eMissedTickPolicy::TSkip);
+	gTaskC->SetMissedTickPolicy(Task::eMissedTickPolicy::TCoalesce);
+	lHandler->SimulateTicks(10);
+
+	// Three periods pass, while the timer interrupt is lost
+	lHandler->SimulateLostTicks(35);
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(4, gCountA);
+	TEST_ASSERT_EQUAL(2, gCountB);
+	TEST_ASSERT_EQUAL(2, gTaskB->GetMissedPeriods());
+	TEST_ASSERT_EQUAL(4, gCountC);
+
+	// All tasks stay in phase
+	lHandler->SimulateTicks(4);
+	TEST_ASSERT_EQUAL(5, gCountA);
+	TEST_ASSERT_EQUAL(3, gCountB);
+	TEST_ASSERT_EQUAL(5, gCountC);
+}
+
+void test_follow_up_and_triggered_tasks()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	lHandler->SetCycleTimeInMs(1);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TOneTime, 5, CountA);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TFollowUpOneTime, 3, CountB);
+	gTaskB->DefinePrevious(gTaskA);
+	gTaskC = Task::GetNewTask(Task::eTaskType::TTriggerOneTime, 4, CountC);
+
+	// B starts counting, when A is done
+	lHandler->SimulateTicks(7);
+	TEST_ASSERT_EQUAL(1, gCountA);
+	TEST_ASSERT_EQUAL(0, gCountB);
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(1, gCountB);
+
+	// C waits for its trigger and waits again after its run
+	TEST_ASSERT_EQUAL(0, gCountC);
+	gTaskC->Start();
+	lHandler->SimulateTicks(3);
+	TEST_ASSERT_EQUAL(0, gCountC);
+	lHandler->SimulateTicks(1);
+	TEST_ASSERT_EQUAL(1, gCountC);
+	lHandler->SimulateTicks(10);
+	TEST_ASSERT_EQUAL(1, gCountC);
+	gTaskC->Start();
+	lHandler->SimulateTicks(4);
+	TEST_ASSERT_EQUAL(2, gCountC);
+}
+
+#if TASKHANDLER_DUAL_CORE
+static std::thread::id gMainThread;
+static std::atomic<int> gRunsOnCore[2];
+static std::atomic<bool> gWrongCore(false);
+
+static void RunOnCore0()
+{
+	gWrongCore = gWrongCore || (std::this_thread::get_id() != gMainThread);
+	gRunsOnCore[0]++;
+}
+
+static void RunOnCore1()
+{
+	gWrongCore = gWrongCore || (std::this_thread::get_id() == gMainThread);
+	gRunsOnCore[1]++;
+}
+
+void test_dual_core_runs_tasks_on_their_core()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+
+	gMainThread = std::this_thread::get_id();
+	gRunsOnCore[0] = 0;
+	gRunsOnCore[1] = 0;
+	gWrongCore = false;
+	lHandler->SetCycleTimeInMs(1);
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TDualCore);
+	lHandler->StartSecondCore();
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 10, RunOnCore0);
+	gTaskA->SetCore(Task::eCore::TCore0);
+	gTaskB = Task::GetNewTask(Task::eTaskType::TCyclic, 10, RunOnCore1);
+	gTaskB->SetCore(Task::eCore::TCore1);
+
+	// The main loop of the 1st core runs, while the thread of the 2nd core processes its queue
+	for (int lPeriod = 0; lPeriod < 10; lPeriod++)
+	{
+		lHandler->SimulateTicks(10);
+		lHandler->RunPending();
+		lHandler->WaitForWorkers();
+	}
+	lHandler->StopSecondCore();
+	lHandler->SetExecutionMode(TaskHandler::eExecutionMode::TImmediate);
+
+	TEST_ASSERT_EQUAL(10, gRunsOnCore[0].load());
+	TEST_ASSERT_EQUAL(10, gRunsOnCore[1].load());
+	TEST_ASSERT_FALSE(gWrongCore);
+}
+#endif
+
+void test_done_tasks_removed_by_main_loop()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	uint8_t lCount = lHandler->GetTaskCount();
+
+	lHandler->SetCycleTimeInMs(1);
+	lHandler->SetAutoReap(true);
+	Task::GetNewTask(Task::eTaskType::TOneTime, 2, CountB);
+
+	// The timer interrupt must not change the task table
+	lHandler->SimulateTicks(5);
+	TEST_ASSERT_EQUAL(1, gCountB);
+	TEST_ASSERT_EQUAL(lCount + 1, lHandler->GetTaskCount());
+
+	lHandler->RunPending();
+	TEST_ASSERT_EQUAL(lCount, lHandler->GetTaskCount());
+}
+
+void test_restagger_spreads_phases()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	Task *lTasks[12];
+
+	lHandler->SetCycleTimeInMs(1);
+	for (int lIndex = 0; lIndex < 8; lIndex++)
+	{
+		lTasks[lIndex] = Task::GetNewTask(Task::eTaskType::TCyclic, 8, CountB);
+	}
+	TEST_ASSERT_EQUAL(8, lHandler->GetWorstCaseLoad());
+
+	lHandler->Restagger();
+	TEST_ASSERT_EQUAL(1, lHandler->GetWorstCaseLoad());
+
+	// New tasks take the free phases
+	lHandler->SetPhaseStaggering(true);
+	for (int lIndex = 8; lIndex < 12; lIndex++)
+	{
+		lTasks[lIndex] = Task::GetNewTask(Task::eTaskType::TCyclic, 16, CountB);
+	}
+	TEST_ASSERT_EQUAL(2, lHandler->GetWorstCaseLoad());
+
+	lHandler->SetPhaseStaggering(false);
+	for (Task *lTask : lTasks)
+	{
+		lTask->Cancel();
+	}
+}
+
+void test_tickless_long_cycle_time()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	unsigned long lDispatches;
+
+	// 200ms do not fit into the 16 bit counter without prescaler
+	lHandler->SetCycleTimeInMs(200, true);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 5, CountB);
+	lDispatches = lHandler->GetDispatchCount();
+
+	lHandler->SimulateTicks(100);
+
+	TEST_ASSERT_EQUAL(20, gCountB);
+	// The timer fires at the deadlines only, not at every tick
+	TEST_ASSERT_LESS_OR_EQUAL(21, lHandler->GetDispatchCount() - lDispatches);
+}
+
+void test_tickless_deadline_beyond_counter()
+{
+	TaskHandler *lHandler = TaskHandler::GetInstance();
+	unsigned long lDispatches;
+
+	// The counter covers 173 ticks of 1ms, longer periods need intermediate wake ups
+	lHandler->SetCycleTimeInMs(1, true);
+	gTaskA = Task::GetNewTask(Task::eTaskType::TCyclic, 1000, CountB);
+	lDispatches = lHandler->GetDispatchCount();
+
+	lHandler->SimulateTicks(3000);
+
+	TEST_ASSERT_EQUAL(3, gCountB);
+	TEST_ASSERT_GREATER_THAN(3, lHandler->GetDispatchCount() - lDispatches);
+	TEST_ASSERT_LESS_THAN(30, lHandler->GetDispatchCount() - lDispatches);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_restart_of_task_due_in_same_tick);
+	RUN_TEST(test_cancel_of_task_due_in_same_tick);
+	RUN_TEST(test_cancel_after_marked_as_ready);
+	RUN_TEST(test_self_cancel_releases_follow_up_once);
+	RUN_TEST(test_parallel_task_runs_on_worker_only);
+	RUN_TEST(test_admission_control_on_resume_and_restart);
+	RUN_TEST(test_missed_tick_policies);
+	RUN_TEST(test_follow_up_and_triggered_tasks);
+#if TASKHANDLER_DUAL_CORE
+	RUN_TEST(test_dual_core_runs_tasks_on_their_core);
+#endif
+	RUN_TEST(test_done_tasks_removed_by_main_loop);
+	RUN_TEST(test_restagger_spreads_phases);
+	RUN_TEST(test_tickless_long_cycle_time);
+	RUN_TEST(test_tickless_deadline_beyond_counter);
+	return UNITY_END();
+}